@@ -0,0 +1,721 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+#define PREFIX_ALLOC_HOOKS
+#include <preFIX_alloc.hpp>
+
+#include <preFIX.hpp>
+#include <preFIX_cache.hpp>
+#include <preFIX_dict.hpp>
+#include <preFIX_md.hpp>
+#include <preFIX_pcap.hpp>
+#include <preFIX_pool.hpp>
+#include <preFIX_sbe.hpp>
+#include <preFIX_segmented.hpp>
+#include <preFIX_shm.hpp>
+#include <preFIX_template.hpp>
+#include <preFIX_transport.hpp>
+
+/**
+ * Benchmark suite. Usage:
+ *   AX_PREFIX_BENCH [--iterations N] [--warmup N] [--filter substr] [--json path] [--corpus path]
+ * Every corpus message is benchmarked per operation (encode/decode/validate...),
+ * per-operation latency percentiles and throughput are reported.
+ * --corpus adds replay of captured traffic (AX_PREFIX_PCAP2CORPUS output).
+ */
+
+using namespace preFIX;
+using namespace preFIX::types;
+using namespace preFIX::dict;
+using namespace test_dict;
+
+namespace {
+    
+    using clock_type = std::chrono::steady_clock;
+    
+    struct options {
+        size_t iterations = 100000;
+        size_t warmup = 10000;
+        std::string filter;
+        std::string json;
+        std::string corpus;
+    };
+    
+    /// One benchmarked operation over one corpus message
+    struct bench_case {
+        std::string message;
+        std::string operation;
+        size_t bytes;                       // processed per call
+        std::function<bool()> run;
+    };
+    
+    struct result {
+        std::string message;
+        std::string operation;
+        size_t bytes;
+        size_t samples;
+        double p50, p99, p999, mean;        // ns per call
+        double msgs_per_s, gb_per_s;
+        double allocs;                      // heap allocations per call (steady state: reused messages)
+    };
+    
+    /// Minimal cost of now() pair, subtracted from samples
+    double timer_overhead() {
+        double best = 1e9;
+        for(int i = 0; i < 1000; ++i) {
+            auto t0 = clock_type::now();
+            auto t1 = clock_type::now();
+            best = std::min(best, double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        }
+        return best;
+    }
+    
+    result measure(bench_case const& bc, options const& opt, double overhead) {
+        for(size_t i = 0; i < opt.warmup; ++i)
+            if(!bc.run())
+                throw std::runtime_error(bc.message + "/" + bc.operation + " failed");
+        
+        // Latency: every call timed separately
+        std::vector<double> samples(opt.iterations);
+        for(auto& s : samples) {
+            auto t0 = clock_type::now();
+            bc.run();
+            auto t1 = clock_type::now();
+            s = std::max(0.0, std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() - overhead);
+        }
+        
+        // Allocations: counted separately to keep timing loops clean
+        enum : size_t { alloc_runs = 100 };
+        auto allocs = alloc::count([&bc]() {
+            for(size_t i = 0; i < alloc_runs; ++i)
+                bc.run();
+        });
+        
+        // Throughput: tight loop
+        auto t0 = clock_type::now();
+        for(size_t i = 0; i < opt.iterations; ++i)
+            bc.run();
+        double total = std::chrono::duration<double>(clock_type::now() - t0).count();
+        
+        std::sort(samples.begin(), samples.end());
+        auto pct = [&samples](double p) {
+            return samples[std::min(samples.size() - 1, size_t(p*samples.size()))]; };
+        
+        double sum = 0;
+        for(double s : samples)
+            sum += s;
+        
+        result r;
+        r.message    = bc.message;
+        r.operation  = bc.operation;
+        r.bytes      = bc.bytes;
+        r.samples    = samples.size();
+        r.p50        = pct(0.5);
+        r.p99        = pct(0.99);
+        r.p999       = pct(0.999);
+        r.mean       = sum/samples.size();
+        r.msgs_per_s = opt.iterations/total;
+        r.gb_per_s   = r.msgs_per_s*bc.bytes/1e9;
+        r.allocs     = double(allocs.allocations)/alloc_runs;
+        return r;
+    }
+    
+    
+    /// ------------------------! Corpus !------------------------ ///
+    
+    struct corpus {
+        Header header;
+        Trailer trailer;
+        
+        Logon logon;
+        NewOrderSingle nos;
+        ExecutionReport exec;
+        NestedGroupsOrder nested;
+        MarketDataIncrementalRefresh md;
+        
+        corpus() {
+            header.set<BeginString> ("FIX.4.4")
+                  .set<SenderCompID>("MYCOMP")
+                  .set<TargetCompID>("THEIRCOMP")
+                  .set<MsgSeqNum>   (123456)
+                  .set<SendingTime> (1492509600123);
+            
+            logon.set<EncryptMethod>(0)
+                 .set<HeartBtInt>   (30)
+                 .set<Password>     ("secret");
+            
+            nos.set<ClOrdID>("ORD-000001")
+               .set<Account>("ACC-42")
+               .set<Price>  (66.6625)
+               .set<Side>   ('2');
+            nos.at<NoPartyID>().resize(2);
+            nos.at<NoPartyID>()[0].set<PartyID>("USER").set<PartyIDSource>('D').set<PartyRole>(12);
+            nos.at<NoPartyID>()[1].set<PartyID>("FIRM").set<PartyIDSource>('D').set<PartyRole>(1);
+            
+            exec.set<OrderID>  ("EX-98765")
+                .set<ClOrdID>  ("ORD-000001")
+                .set<ExecID>   ("E-1")
+                .set<ExecType> ('F')
+                .set<OrdStatus>('1')
+                .set<Account>  ("ACC-42")
+                .set<Symbol>   ("EURUSD")
+                .set<Side>     ('2')
+                .set<OrderQty> (1000000)
+                .set<Price>    (1.0835)
+                .set<LastQty>  (250000)
+                .set<LastPx>   (1.0835)
+                .set<LeavesQty>(750000)
+                .set<CumQty>   (250000)
+                .set<AvgPx>    (1.0835)
+                .set<TransactTime>(1492509600123456);
+            exec.at<NoPartyID>().resize(1);
+            exec.at<NoPartyID>()[0].set<PartyID>("USER").set<PartyRole>(12);
+            
+            nested.set<Account>("Nested!").set<Password>("PSSWD");
+            nested.at<NoOrders>().resize(3);
+            for(int i = 0; i < 3; ++i) {
+                auto& order = nested.at<NoOrders>()[i];
+                order.set<ClOrdID>("ORD-" + std::to_string(i));
+                order.at<NoPartyID>().resize(3);
+                for(int j = 0; j < 3; ++j)
+                    order.at<NoPartyID>()[j].set<PartyID>("P" + std::to_string(j)).set<PartyRole>(j);
+            }
+            
+            auto& entries = md.at<NoMDEntries>().resize(4);
+            for(int i = 0; i < 4; ++i)
+                entries[i].set<MDUpdateAction>(char('0' + i%3))
+                          .set<MDEntryType>   (char('0' + i%2))
+                          .set<Symbol>        ("EURUSD")
+                          .set<MDEntryPx>     (1.0830 + i*0.0001)
+                          .set<MDEntrySize>   ((i + 1)*1e6);
+        }
+    };
+    
+    /// Encoded message kept alive for decode/validate benchmarks
+    struct wire {
+        std::vector<char> data;
+        std::vector<char> out;
+    };
+    
+    /// In-process initiator/acceptor pair over loopback TCP
+    struct loopback {
+        struct handler {
+            net::connection* initiator = nullptr;
+            size_t at_initiator = 0;
+            size_t at_acceptor = 0;
+            bool echo = true;
+            
+            void on_connect(net::connection&) {}
+            
+            void on_message(net::connection& c, read_cursor& msg) {
+                if(&c == initiator) {
+                    ++at_initiator;
+                } else {
+                    ++at_acceptor;
+                    if(echo)
+                        c.send_raw(msg.pointer(), msg.left());
+                }
+            }
+            
+            void on_close(net::connection&) {}
+        };
+        
+        handler h;
+        net::reactor<handler> r;
+        
+        static net::options busy() {
+            net::options opt;
+            opt.busy_poll = true;
+            return opt;
+        }
+        
+        loopback() : r(h, busy()) {}
+        
+        bool open() {
+            int lfd = r.listen("127.0.0.1", 0);
+            if(lfd < 0)
+                return false;
+            h.initiator = r.connect("127.0.0.1", net::reactor<handler>::local_port(lfd));
+            for(int i = 0; h.initiator && i < 100000 && r.connections() < 3; ++i)
+                r.poll(0);
+            return h.initiator && h.initiator->connected() && r.connections() == 3;
+        }
+        
+        /// Busy polls until counter reaches value
+        bool wait(size_t const& counter, size_t value) {
+            for(long i = 0; counter < value; ++i)
+                if(r.poll(0) < 0 || i > 100000000L)
+                    return false;
+            return true;
+        }
+    };
+    
+    /// Echo process behind pair of shared memory rings (ping => pong)
+    struct shm_pingpong {
+        std::string ping_path = "/dev/shm/preFIX_bench_ping_" + std::to_string(::getpid());
+        std::string pong_path = "/dev/shm/preFIX_bench_pong_" + std::to_string(::getpid());
+        ipc::shm_ring ping;
+        ipc::shm_ring pong;
+        pid_t child = -1;
+        
+        bool open() {
+            if(!ping.create(ping_path, 1024, 64) || !pong.create(pong_path, 1024, 64))
+                return false;
+            
+            child = ::fork();
+            if(child == 0) {
+                while(!ping.closed()) {
+                    ping.wait(1000);
+                    ping.poll([this](read_cursor& msg) {
+                        auto slot = pong.reserve();
+                        std::memcpy(slot.cursor.pointer(), msg.pointer(), msg.left());
+                        slot.cursor.step(msg.left());
+                        pong.commit(slot);
+                    });
+                }
+                ::_exit(0);
+            }
+            return child > 0;
+        }
+        
+        /// Spins, then sleeps until echo arrives
+        bool wait() {
+            return pong.wait(1000000) && pong.poll([](read_cursor&) {}, 1) == 1; }
+        
+        ~shm_pingpong() {
+            if(child > 0) {
+                ping.shutdown();
+                ::waitpid(child, nullptr, 0);
+            }
+            ::unlink(ping_path.c_str());
+            ::unlink(pong_path.c_str());
+        }
+    };
+    
+    template <typename Body>
+    void add_message(std::vector<bench_case>& cases, std::vector<std::shared_ptr<wire>>& wires,
+        corpus& c, std::string const& name, char const* msg_type, Body& body)
+    {
+        auto w = std::make_shared<wire>();
+        wires.push_back(w);
+        w->out.resize(4096);
+        w->data.resize(4096);
+        
+        Header* header = &c.header;
+        Trailer* trailer = &c.trailer;
+        Body* msg = &body;
+        
+        auto encode = [=]() {
+            header->template set<MsgType>(msg_type);
+            write_cursor dst(w->out.data(), w->out.size());
+            return serialize_message(dst, *header, *msg, *trailer);
+        };
+        
+        write_cursor dst(w->data.data(), w->data.size());
+        header->template set<MsgType>(msg_type);
+        serialize_message(dst, *header, *msg, *trailer);
+        w->data.resize(dst.processed());
+        size_t bytes = w->data.size();
+        
+        cases.push_back({name, "encode", bytes, encode});
+        
+        // Decoded messages are reused between calls, as a session would do
+        auto h = std::make_shared<Header>();
+        auto b = std::make_shared<Body>();
+        auto t = std::make_shared<Trailer>();
+        
+        cases.push_back({name, "decode", bytes, [=]() {
+            read_cursor src(w->data.data(), w->data.size());
+            return h->deserialize(src) && b->deserialize(src) && t->deserialize(src) && src.left() == 0;
+        }});
+        
+        cases.push_back({name, "validate", bytes, [=]() {
+            return validate_message(read_cursor(w->data.data(), w->data.size())); }});
+        
+        cases.push_back({name, "frame", bytes, [=]() {
+            return frame_message(read_cursor(w->data.data(), w->data.size())) == int(w->data.size()); }});
+        
+        // Same message in binary encoding (bytes = binary size)
+        auto bin = std::make_shared<wire>();
+        bin->out.resize(4096);
+        bin->data.resize(4096);
+        write_cursor bdst(bin->data.data(), bin->data.size());
+        sbe::serialize_binary_message(bdst, *header, *msg);
+        bin->data.resize(bdst.processed());
+        size_t bin_bytes = bin->data.size();
+        
+        cases.push_back({name, "encode_binary", bin_bytes, [=]() {
+            header->template set<MsgType>(msg_type);
+            write_cursor dst(bin->out.data(), bin->out.size());
+            return sbe::serialize_binary_message(dst, *header, *msg);
+        }});
+        
+        cases.push_back({name, "decode_binary", bin_bytes, [=]() {
+            read_cursor src(bin->data.data(), bin->data.size());
+            return sbe::deserialize_binary_message(src, *h, *b) && src.left() == 0;
+        }});
+    }
+    
+    void print(result const& r) {
+        std::printf("%-22s %-16s %6zu %10.1f %10.1f %10.1f %10.1f %12.0f %8.3f %7.2f\n",
+            r.message.c_str(), r.operation.c_str(), r.bytes,
+            r.p50, r.p99, r.p999, r.mean, r.msgs_per_s, r.gb_per_s, r.allocs);
+    }
+    
+    void write_json(std::string const& path, std::vector<result> const& results) {
+        std::ofstream out(path);
+        out << "[\n";
+        for(size_t i = 0; i < results.size(); ++i) {
+            auto const& r = results[i];
+            out << "  {\"message\": \"" << r.message
+                << "\", \"operation\": \"" << r.operation
+                << "\", \"bytes\": " << r.bytes
+                << ", \"samples\": " << r.samples
+                << ", \"p50_ns\": " << r.p50
+                << ", \"p99_ns\": " << r.p99
+                << ", \"p999_ns\": " << r.p999
+                << ", \"mean_ns\": " << r.mean
+                << ", \"msgs_per_s\": " << r.msgs_per_s
+                << ", \"gb_per_s\": " << r.gb_per_s
+                << ", \"allocs_per_call\": " << r.allocs
+                << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+
+} // anonymous
+
+int main(int argc, char** argv) {
+    options opt;
+    try {
+        for(int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if(i + 1 >= argc)
+                    throw std::invalid_argument("missing value for " + arg);
+                return argv[++i];
+            };
+            auto number = [&]() -> size_t {
+                std::string value = next();
+                size_t pos = 0;
+                try {
+                    size_t res = std::stoul(value, &pos);
+                    if(pos == value.size() && value[0] != '-')
+                        return res;
+                } catch(std::exception const&) {}
+                throw std::invalid_argument("invalid value for " + arg + ": " + value);
+            };
+            
+            if(arg == "--iterations")   opt.iterations = number();
+            else if(arg == "--warmup")  opt.warmup = number();
+            else if(arg == "--filter")  opt.filter = next();
+            else if(arg == "--json")    opt.json = next();
+            else if(arg == "--corpus")  opt.corpus = next();
+            else
+                throw std::invalid_argument("unknown argument " + arg);
+        }
+        if(opt.iterations == 0)
+            throw std::invalid_argument("--iterations must be positive");
+    } catch(std::exception const& e) {
+        std::fprintf(stderr, "%s\nusage: %s [--iterations N] [--warmup N] [--filter substr] [--json path] [--corpus path]\n",
+            e.what(), argv[0]);
+        return 1;
+    }
+    
+    corpus c;
+    std::vector<bench_case> cases;
+    std::vector<std::shared_ptr<wire>> wires;
+    
+    add_message(cases, wires, c, "Logon",            "A", c.logon);
+    add_message(cases, wires, c, "NewOrderSingle",   "D", c.nos);
+    add_message(cases, wires, c, "ExecutionReport",  "8", c.exec);
+    add_message(cases, wires, c, "NestedGroups",     "D", c.nested);
+    add_message(cases, wires, c, "MDIncremental",    "X", c.md);
+    
+    // Specialized paths
+    
+    auto tpl = std::make_shared<msg_template<Header, NewOrderSingle, MsgSeqNum, SendingTime, ClOrdID, Price>>();
+    c.header.set<MsgType>("D");
+    tpl->build(c.header, c.nos);
+    auto tpl_out = std::make_shared<std::vector<char>>(4096);
+    cases.push_back({"NewOrderSingle", "encode_template", wires[1]->data.size(), [=, &c]() {
+        write_cursor dst(tpl_out->data(), tpl_out->size());
+        return tpl->serialize(dst, c.header, c.nos);
+    }});
+    
+    auto books = std::make_shared<md::book_set<16>>();
+    auto decoder = std::make_shared<md::md_decoder<16>>(*books);
+    auto md_wire = wires[4];
+    cases.push_back({"MDIncremental", "decode_book", md_wire->data.size(), [=]() {
+        read_cursor src(md_wire->data.data(), md_wire->data.size());
+        return decoder->decode(src);
+    }});
+    
+    auto cached = std::make_shared<cached_msg_t<ClOrdID, Account, NoPartyID, Price, Side>>();
+    cached->set<ClOrdID>("ORD-000001").set<Account>("ACC-42").set<Price>(66.6625).set<Side>('2');
+    cached->modify<NoPartyID>([](NoPartyID& parties) {
+        parties.resize(2);
+        parties[0].set<PartyID>("USER").set<PartyIDSource>('D').set<PartyRole>(12);
+        parties[1].set<PartyID>("FIRM").set<PartyIDSource>('D').set<PartyRole>(1);
+    });
+    cases.push_back({"NewOrderSingle", "encode_cached", wires[1]->data.size(), [=, &c]() {
+        cached->set<Side>(cached->at<Side>().value == '1' ? '2' : '1');
+        write_cursor dst(tpl_out->data(), tpl_out->size());
+        return serialize_message(dst, c.header, *cached, c.trailer);
+    }});
+    
+    // Pooled buffer per message (acquire => encode => release to thread cache)
+    auto pool = std::make_shared<buffer_pool>(4096, 256);
+    cases.push_back({"NewOrderSingle", "encode_pooled", wires[1]->data.size(), [=, &c]() {
+        auto buf = pool->acquire();
+        auto dst = buf.writer();
+        return serialize_message(dst, c.header, c.nos, c.trailer);
+    }});
+    
+    // Outbound batch: copying into staging buffer vs segmented output (writev-ready)
+    enum : int { batch = 32 };
+    auto staging = std::make_shared<std::vector<char>>(batch*4096);
+    cases.push_back({"Batch32xNOS", "encode_staged", batch*wires[1]->data.size(), [=, &c]() {
+        size_t used = 0;
+        for(int i = 0; i < batch; ++i) {
+            write_cursor dst(tpl_out->data(), tpl_out->size());
+            if(!serialize_message(dst, c.header, c.nos, c.trailer))
+                return false;
+            std::memcpy(staging->data() + used, tpl_out->data(), dst.processed());
+            used += dst.processed();
+        }
+        return used > 0;
+    }});
+    
+    struct segmented_output {
+        block_pool pool;
+        segmented_cursor out;   // destroyed before pool
+        segmented_output() : pool(4096, 16), out(pool) {}
+    };
+    auto segmented = std::make_shared<segmented_output>();
+    cases.push_back({"Batch32xNOS", "encode_segmented", batch*wires[1]->data.size(), [=, &c]() {
+        for(int i = 0; i < batch; ++i)
+            if(!serialize_message(segmented->out, c.header, c.nos, c.trailer))
+                return false;
+        iovec iov[64];
+        bool res = segmented->out.to_iovec(iov, 64) > 0;
+        segmented->out.consume(segmented->out.size());
+        return res;
+    }});
+    
+    // Synthetic incremental feed: book vs msg_t decoding
+    auto feed = std::make_shared<std::vector<std::string>>();
+    {
+        const char* symbols[] = {"EURUSD", "USDJPY", "GBPUSD", "AUDUSD"};
+        unsigned rnd = 42;
+        auto next = [&rnd] { return rnd = rnd*1103515245 + 12345, (rnd >> 16) & 0x7FFF; };
+        
+        MarketDataIncrementalRefresh inc;
+        c.header.set<MsgType>("X");
+        std::vector<char> buf(4096);
+        for(int m = 0; m < 1024; ++m) {
+            auto& entries = inc.at<NoMDEntries>().resize(1 + next()%4);
+            for(size_t i = 0; i < entries.value.size(); ++i)
+                entries[i].set<MDUpdateAction>(char('0' + next()%3))
+                          .set<MDEntryType>   (char('0' + next()%2))
+                          .set<Symbol>        (symbols[next()%4])
+                          .set<MDEntryPx>     (1.0 + (next()%64)*0.0001)
+                          .set<MDEntrySize>   ((1 + next()%10)*1e5);
+            c.header.set<MsgSeqNum>(m);
+            write_cursor dst(buf.data(), buf.size());
+            serialize_message(dst, c.header, inc, c.trailer);
+            feed->emplace_back(buf.data(), dst.processed());
+        }
+    }
+    size_t feed_bytes = 0;
+    for(auto const& msg : *feed)
+        feed_bytes += msg.size();
+    
+    auto feed_pos = std::make_shared<size_t>(0);
+    cases.push_back({"MDFeed", "decode_book", feed_bytes/feed->size(), [=]() {
+        auto const& msg = (*feed)[(*feed_pos)++ % feed->size()];
+        read_cursor src(msg.data(), msg.size());
+        return decoder->decode(src);
+    }});
+    auto feed_header = std::make_shared<Header>();
+    auto feed_msg = std::make_shared<MarketDataIncrementalRefresh>();
+    auto feed_trailer = std::make_shared<Trailer>();
+    cases.push_back({"MDFeed", "decode", feed_bytes/feed->size(), [=]() {
+        auto const& msg = (*feed)[(*feed_pos)++ % feed->size()];
+        read_cursor src(msg.data(), msg.size());
+        return feed_header->deserialize(src) && feed_msg->deserialize(src) && feed_trailer->deserialize(src);
+    }});
+    
+    // Single fields
+    auto ts = std::make_shared<UTCTimestamp<precision::us>>(utc_now<precision::us>());
+    auto ts_out = std::make_shared<std::vector<char>>(64);
+    cases.push_back({"UTCTimestamp", "encode", 28, [=]() {
+        ts->value += 7;
+        write_cursor dst(ts_out->data(), ts_out->size());
+        return ts->serialize(dst);
+    }});
+    cases.push_back({"UTCTimestamp", "decode", 28, [=]() {
+        UTCTimestamp<precision::us> parsed;
+        read_cursor src(ts_out->data(), ts_out->size());
+        return parsed.deserialize(src);
+    }});
+    
+    // Embedded 4 KiB payload (FIXML-like, contains SOH): copied vs referenced in place
+    using XmlDataLen  = field_base<212, Int>;
+    using XmlData     = field_base<213, Data<XmlDataLen>>;
+    using XmlDataView = field_base<213, DataView<XmlDataLen>>;
+    using xml_msg      = msg_t<ClOrdID, XmlDataLen, XmlData>;
+    using xml_view_msg = msg_t<ClOrdID, XmlDataLen, XmlDataView>;
+    
+    auto xml_wire = std::make_shared<std::vector<char>>(8192);
+    int xml_size = 0;
+    {
+        std::string payload;
+        while(payload.size() < 4096)
+            payload += "<Order ID=\"1\" Px=\"1.25\"/>\x01";
+        xml_msg m;
+        m.set<ClOrdID>("ORD-000001").set<XmlData>(payload);
+        write_cursor dst(xml_wire->data(), xml_wire->size());
+        m.serialize(dst);
+        xml_size = dst.processed();
+    }
+    auto xml = std::make_shared<xml_msg>();
+    auto xml_view = std::make_shared<xml_view_msg>();
+    cases.push_back({"XmlData4K", "decode_copy", size_t(xml_size), [=]() {
+        read_cursor src(xml_wire->data(), xml_size);
+        return xml->deserialize(src) && src.left() == 0;
+    }});
+    cases.push_back({"XmlData4K", "decode_view", size_t(xml_size), [=]() {
+        read_cursor src(xml_wire->data(), xml_size);
+        return xml_view->deserialize(src) && src.left() == 0;
+    }});
+    
+    // Loopback TCP (epoll transport): echo round trip and one-way batches
+    auto lo = std::make_shared<loopback>();
+    if(lo->open()) {
+        c.header.set<MsgType>("D");
+        cases.push_back({"Loopback", "round_trip", wires[1]->data.size(), [=, &c]() {
+            lo->h.echo = true;
+            size_t expected = lo->h.at_initiator + 1;
+            return lo->h.initiator->send(c.header, c.nos, c.trailer) && lo->wait(lo->h.at_initiator, expected);
+        }});
+        cases.push_back({"Loopback", "one_way_batch32", batch*wires[1]->data.size(), [=, &c]() {
+            lo->h.echo = false;
+            size_t expected = lo->h.at_acceptor + batch;
+            for(int i = 0; i < batch; ++i)
+                if(!lo->h.initiator->send(c.header, c.nos, c.trailer))
+                    return false;
+            lo->r.flush();
+            return lo->wait(lo->h.at_acceptor, expected);
+        }});
+    } else {
+        std::fprintf(stderr, "# loopback transport is unavailable, skipped\n");
+    }
+    
+    // Shared memory rings to echo process: round trip = two cross-process hops
+    auto shm = std::make_shared<shm_pingpong>();
+    if(shm->open()) {
+        c.header.set<MsgType>("D");
+        cases.push_back({"SharedMemory", "round_trip", wires[1]->data.size(), [=, &c]() {
+            auto slot = shm->ping.reserve();
+            if(!serialize_message(slot.cursor, c.header, c.nos, c.trailer)) {
+                shm->ping.cancel(slot);
+                return false;
+            }
+            shm->ping.commit(slot);
+            return shm->wait();
+        }});
+    } else {
+        std::fprintf(stderr, "# shared memory ring is unavailable, skipped\n");
+    }
+    
+    // Captured traffic: real message mix, cycled in capture order
+    if(!opt.corpus.empty()) {
+        pcap::mapped_file file;
+        pcap::corpus_reader reader;
+        if(!file.open(opt.corpus) || !reader.open(file.data(), file.size())) {
+            std::fprintf(stderr, "can't read corpus %s\n", opt.corpus.c_str());
+            return 1;
+        }
+        
+        auto replay = std::make_shared<std::vector<std::string>>();
+        auto replay_md = std::make_shared<std::vector<std::string>>();
+        size_t replay_bytes = 0, replay_md_bytes = 0;
+        std::uint64_t first_ts = 0, last_ts = 0;
+        pcap::record r{0, 0, read_cursor(nullptr, 0)};
+        while(reader.next(r)) {
+            std::string msg(r.frame.pointer(), r.frame.left());
+            first_ts = replay->empty() ? r.timestamp_ns : first_ts;
+            last_ts = r.timestamp_ns;
+            replay_bytes += msg.size();
+            
+            size_t type = msg.find("\x01" "35=");
+            if(type != std::string::npos && type + 6 < msg.size() &&
+               (msg[type + 4] == 'X' || msg[type + 4] == 'W') && msg[type + 5] == SOH) {
+                replay_md_bytes += msg.size();
+                replay_md->push_back(msg);
+            }
+            replay->push_back(std::move(msg));
+        }
+        if(reader.error() || replay->empty()) {
+            std::fprintf(stderr, "corpus %s is empty or truncated\n", opt.corpus.c_str());
+            return 1;
+        }
+        std::printf("# corpus: %zu messages (%zu market data), %.3f s captured, %.0f msgs/s\n",
+            replay->size(), replay_md->size(), (last_ts - first_ts)/1e9,
+            last_ts > first_ts ? replay->size()*1e9/(last_ts - first_ts) : 0.0);
+        
+        auto replay_pos = std::make_shared<size_t>(0);
+        cases.push_back({"Replay", "frame", replay_bytes/replay->size(), [=]() {
+            auto const& msg = (*replay)[(*replay_pos)++ % replay->size()];
+            return dict::frame_message(read_cursor(msg.data(), msg.size())) == int(msg.size());
+        }});
+        cases.push_back({"Replay", "validate", replay_bytes/replay->size(), [=]() {
+            auto const& msg = (*replay)[(*replay_pos)++ % replay->size()];
+            return dict::validate_message(read_cursor(msg.data(), msg.size()));
+        }});
+        if(!replay_md->empty()) {
+            cases.push_back({"Replay", "decode_book", replay_md_bytes/replay_md->size(), [=]() {
+                auto const& msg = (*replay_md)[(*replay_pos)++ % replay_md->size()];
+                read_cursor src(msg.data(), msg.size());
+                return decoder->decode(src);
+            }});
+        }
+    }
+    
+    double overhead = timer_overhead();
+    std::printf("# iterations=%zu warmup=%zu timer_overhead_ns=%.1f\n", opt.iterations, opt.warmup, overhead);
+    std::printf("%-22s %-16s %6s %10s %10s %10s %10s %12s %8s %7s\n",
+        "message", "operation", "bytes", "p50_ns", "p99_ns", "p99.9_ns", "mean_ns", "msgs/s", "GB/s", "allocs");
+    
+    // Failed case is reported and skipped, exit code shows the failure
+    std::vector<result> results;
+    int failed = 0;
+    for(auto const& bc : cases) {
+        if(!opt.filter.empty() && (bc.message + "/" + bc.operation).find(opt.filter) == std::string::npos)
+            continue;
+        try {
+            results.push_back(measure(bc, opt, overhead));
+            print(results.back());
+        } catch(std::exception const& e) {
+            std::fprintf(stderr, "# %s\n", e.what());
+            ++failed;
+        }
+    }
+    
+    if(!opt.json.empty())
+        write_json(opt.json, results);
+    
+    return failed ? 1 : 0;
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <chrono>
 #include <cstring>
 #include <initializer_list>
 #include <iomanip>
@@ -10,6 +11,7 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 #define LOG_HEAD "[preFIX]: "
 
@@ -23,56 +25,77 @@ namespace preFIX {
                 return {{ Idx... }}; }
         };
         
-        /// Finds minimal value inside sequence
-        template <typename>
-        struct min_idx;
+        /// Fixed array usable inside constexpr functions (std::array isn't before C++17)
+        template <size_t N>
+        struct ct_int_array {
+            int data[N > 0 ? N : 1];
+            
+            inline constexpr int& operator[](size_t i) {
+                return data[i]; }
+            
+            inline constexpr int const& operator[](size_t i) const {
+                return data[i]; }
+        };
         
-        template <int X>
-        struct min_idx<int_seq<X>> { enum : int { value = X }; };
+        /// Bottom-up merge sort, O(N*log(N)) steps of constant evaluation
+        template <size_t N>
+        constexpr ct_int_array<N> ct_sort(ct_int_array<N> a) {
+            ct_int_array<N> tmp{};
+            for(size_t width = 1; width < N; width *= 2) {
+                for(size_t lo = 0; lo < N; lo += 2*width) {
+                    size_t mid = (lo + width < N) ? lo + width : N;
+                    size_t hi = (lo + 2*width < N) ? lo + 2*width : N;
+                    size_t i = lo, j = mid, k = lo;
+                    while(i < mid && j < hi)
+                        tmp[k++] = (a[j] < a[i]) ? a[j++] : a[i++];
+                    while(i < mid)
+                        tmp[k++] = a[i++];
+                    while(j < hi)
+                        tmp[k++] = a[j++];
+                }
+                for(size_t k = 0; k < N; ++k)
+                    a[k] = tmp[k];
+            }
+            return a;
+        }
         
-        template <int Head, int... Tail>
-        struct min_idx<int_seq<Head, Tail...>> {
-            enum : int {
-                min_tail = min_idx<int_seq<Tail...>>::value,
-                value = Head < min_tail ? Head : min_tail
-            };
-        };
+        /// Checks sorted array for duplicates
+        template <size_t N>
+        constexpr bool ct_unique(ct_int_array<N> const& a) {
+            for(size_t i = 1; i < N; ++i)
+                if(a[i - 1] == a[i])
+                    return false;
+            return true;
+        }
         
-        /// Removes first found element from int_seq
-        template <int, typename, typename = int_seq<>>
-        struct filter_int_seq;
+        template <int... Keys>
+        struct sorted_keys {
+            static constexpr ct_int_array<sizeof...(Keys)> value =
+                ct_sort(ct_int_array<sizeof...(Keys)>{{ Keys... }});
+        };
         
-        template <int X, typename Seq2>
-        struct filter_int_seq<X, int_seq<>, Seq2> {
-            using type = Seq2; };
+        template <int... Keys>
+        constexpr ct_int_array<sizeof...(Keys)> sorted_keys<Keys...>::value;
         
-        template <int X, int... Seq1, int... Seq2>
-        struct filter_int_seq<X, int_seq<X, Seq1...>, int_seq<Seq2...>> {
-            using type = int_seq<Seq2..., Seq1...>; };
+        template <typename Sorted, typename Idx>
+        struct sorted_int_seq;
         
-        template <int X, int Y, int... Seq1, int... Seq2>
-        struct filter_int_seq<X, int_seq<Y, Seq1...>, int_seq<Seq2...>> {
-            using type = typename filter_int_seq<X,
-                int_seq<Seq1...>,
-                int_seq<Seq2..., Y>
-            >::type;
-        };
+        template <typename Sorted, size_t... I>
+        struct sorted_int_seq<Sorted, std::index_sequence<I...>> {
+            using type = int_seq<Sorted::value[I]...>; };
         
-        template <typename, typename = int_seq<>>
+        template <typename>
         struct sort_int_seq;
         
-        template <int... Seq2>
-        struct sort_int_seq<int_seq<>, int_seq<Seq2...>> {
-            using type = int_seq<Seq2...>; };
-        
-        template <int... Seq1, int... Seq2>
-        struct sort_int_seq<int_seq<Seq1...>, int_seq<Seq2...>> {
-            enum : int { min = min_idx<int_seq<Seq1...>>::value };
-            using filtered = typename filter_int_seq<min, int_seq<Seq1...>>::type;
-            using type = typename sort_int_seq<filtered, int_seq<Seq2..., min>>::type;
+        template <int... Keys>
+        struct sort_int_seq<int_seq<Keys...>> {
+            using sorted = sorted_keys<Keys...>;
+            using type = typename sorted_int_seq<sorted,
+                std::make_index_sequence<sizeof...(Keys)>
+            >::type;
         };
         
-        /// Sorts given integer sequence (by selection sort)
+        /// Sorts given integer sequence (by constexpr merge sort)
         template <typename Seq>
         using sort_int_seq_t = typename sort_int_seq<Seq>::type;
         
@@ -82,6 +105,8 @@ namespace preFIX {
             enum : int { size = sizeof...(Keys) };
             using sorted_seq = sort_int_seq_t<int_seq<Keys...>>;
             
+            static_assert(ct_unique(sorted_keys<Keys...>::value), "duplicate keys (tags) inside index_map");
+            
             /// Binary search algorithm
             static int idx_of(int key) {
                 constexpr auto keys = sorted_seq::to_array();
@@ -96,7 +121,7 @@ namespace preFIX {
                 }
                 
                 idx = ab[0];
-                return keys[idx] == key ? idx : size;
+                return idx != size && keys[idx] == key ? idx : size;
             }
         };
         
@@ -145,11 +170,20 @@ namespace preFIX {
         return str;
     }
     
+    /// Sum of bytes taken as unsigned (CheckSum: binary Data may contain bytes >= 0x80)
+    inline int sum_bytes(char const* ptr, size_t size) {
+        unsigned sum = 0;
+        for(size_t i = 0; i < size; ++i)
+            sum += static_cast<unsigned char>(ptr[i]);
+        return int(sum);
+    }
+    
     
     using    Int_underlying = long;
     using  Float_underlying = double;
     using   Char_underlying = char;
     using String_underlying = std::string;
+    using   Time_underlying = std::int64_t;
     
     /// Contains static value() function returning null-value of given type
     template <typename T>
@@ -211,6 +245,7 @@ namespace preFIX {
 }
 
 #include <preFIX_config.hpp>
+#include <preFIX_stats.hpp>
 
 namespace preFIX {
 
@@ -253,11 +288,18 @@ namespace types {
         
         
         virtual bool serialize(write_cursor& dst) const override {
-            return serializer::serialize(dst, value); }
+            PREFIX_STATS_SERIALIZE(fix_value_type, dst);
+            return serializer::serialize(dst, value);
+        }
         
         virtual bool deserialize(read_cursor& src) override {
             //std::printf("-- deser of %s\n", typeid(*this).name());
-            return deserializer::deserialize(src, value);
+            PREFIX_STATS_DESERIALIZE(fix_value_type, src);
+            PREFIX_STATS_ONLY(auto capacity = stats::capacity_of(value);)
+            bool res = deserializer::deserialize(src, value);
+            PREFIX_STATS_ADD(fix_value_type, allocations, stats::capacity_of(value) > capacity);
+            PREFIX_STATS_ADD(fix_value_type, failures, !res);
+            return res;
         }
     };
     
@@ -272,6 +314,36 @@ namespace types {
     template <size_t Width>
     using Fixed = fix_value_type<Int_underlying, details::fixed_width_int_serializer<Width>>;
     
+    /// Fractional digits of seconds for UTCTimestamp/UTCTime
+    struct precision {
+        enum : int { s = 0, ms = 3, us = 6, ns = 9 };
+    };
+    
+    /// FIX UTCTimestamp, value = 10^-Digits seconds since epoch
+    template <int Digits = precision::ms>
+    using UTCTimestamp = fix_value_type<Time_underlying,
+        details::utc_timestamp_serializer<Digits>,
+        details::utc_timestamp_deserializer<Digits>>;
+    
+    /// FIX UTCDateOnly, value = days since epoch
+    using UTCDate = fix_value_type<Time_underlying,
+        details::utc_date_serializer,
+        details::utc_date_deserializer>;
+    
+    /// FIX UTCTimeOnly, value = 10^-Digits seconds since midnight
+    template <int Digits = precision::ms>
+    using UTCTime = fix_value_type<Time_underlying,
+        details::utc_time_serializer<Digits>,
+        details::utc_time_deserializer<Digits>>;
+    
+    /// Current time as UTCTimestamp<Digits> value
+    template <int Digits = precision::ms>
+    Time_underlying utc_now() {
+        using namespace std::chrono;
+        auto ns = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+        return ns/details::chrono::pow10(9 - Digits);
+    }
+    
     /// Writes preamble: "TAG=", @returns populated size
     bool serialize_tag(Int const& tag, write_cursor& dst) {
         return Int::serializer_type::serialize(dst, tag.value, '='); }
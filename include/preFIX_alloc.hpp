@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Heap allocation counters for tests and benchmarks. Hooks (replacement
+ * operator new/delete, plus malloc family on glibc without sanitizers)
+ * are compiled in by defining PREFIX_ALLOC_HOOKS before inclusion in
+ * exactly one translation unit of the program:
+ *   #define PREFIX_ALLOC_HOOKS
+ *   #include <preFIX_alloc.hpp>
+ *   ...
+ *   auto c = alloc::steady_state([&]() { serialize_message(wc.reset(), h, msg, t); });
+ *   LIGHT_TEST(c.allocations == 0);
+ */
+namespace preFIX { namespace alloc {
+    
+    struct counters {
+        size_t allocations;
+        size_t deallocations;
+        size_t bytes;
+    };
+    
+    /// Counters of calling thread (constant-initialized => usable inside hooks)
+    inline counters& thread_counters() {
+        static thread_local counters value{0, 0, 0};
+        return value;
+    }
+    
+    namespace details {
+        inline void on_alloc(size_t size) {
+            auto& c = thread_counters();
+            ++c.allocations;
+            c.bytes += size;
+        }
+        
+        inline void on_free(void* ptr) {
+            if(ptr)
+                ++thread_counters().deallocations;
+        }
+    } // details
+    
+    /// Allocations made by f() on calling thread
+    template <typename F>
+    counters count(F&& f) {
+        counters before = thread_counters();
+        f();
+        counters after = thread_counters();
+        return {after.allocations - before.allocations,
+                after.deallocations - before.deallocations,
+                after.bytes - before.bytes};
+    }
+    
+    /// Warms f() up (buffers reach their capacity), then counts `runs` calls
+    template <typename F>
+    counters steady_state(F&& f, int warmup = 3, int runs = 10) {
+        for(int i = 0; i < warmup; ++i)
+            f();
+        return count([&f, runs]() {
+            for(int i = 0; i < runs; ++i)
+                f(); });
+    }
+    
+    /// False if hooks aren't compiled in (all counts would be zero)
+    inline bool hooks_installed() {
+        return count([]() {
+            char* volatile ptr = new char;
+            delete ptr;
+        }).allocations != 0;
+    }
+
+} // alloc
+} // preFIX
+
+
+#ifdef PREFIX_ALLOC_HOOKS
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define PREFIX_ALLOC_HOOKS_MALLOC 1
+#endif
+
+#ifdef PREFIX_ALLOC_HOOKS_MALLOC
+
+/// glibc allows replacing malloc family, originals stay reachable as __libc_*
+extern "C" {
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void  __libc_free(void*);
+    
+    void* malloc(size_t size) {
+        preFIX::alloc::details::on_alloc(size);
+        return __libc_malloc(size);
+    }
+    
+    void* calloc(size_t count, size_t size) {
+        preFIX::alloc::details::on_alloc(count*size);
+        return __libc_calloc(count, size);
+    }
+    
+    void* realloc(void* ptr, size_t size) {
+        preFIX::alloc::details::on_free(ptr);
+        preFIX::alloc::details::on_alloc(size);
+        return __libc_realloc(ptr, size);
+    }
+    
+    void free(void* ptr) {
+        preFIX::alloc::details::on_free(ptr);
+        __libc_free(ptr);
+    }
+}
+
+#endif
+
+namespace preFIX { namespace alloc { namespace details {
+    /// Counted once: by malloc hook if it's installed
+    inline void* hooked_new(size_t size) {
+    #ifndef PREFIX_ALLOC_HOOKS_MALLOC
+        on_alloc(size);
+    #endif
+        void* ptr = std::malloc(size ? size : 1);
+        if(!ptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+    
+    inline void hooked_delete(void* ptr) noexcept {
+    #ifndef PREFIX_ALLOC_HOOKS_MALLOC
+        on_free(ptr);
+    #endif
+        std::free(ptr);
+    }
+}}}
+
+void* operator new(size_t size) {
+    return preFIX::alloc::details::hooked_new(size); }
+
+void* operator new[](size_t size) {
+    return preFIX::alloc::details::hooked_new(size); }
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept {
+    try { return preFIX::alloc::details::hooked_new(size); } catch(...) { return nullptr; } }
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept {
+    try { return preFIX::alloc::details::hooked_new(size); } catch(...) { return nullptr; } }
+
+void operator delete(void* ptr) noexcept {
+    preFIX::alloc::details::hooked_delete(ptr); }
+
+void operator delete[](void* ptr) noexcept {
+    preFIX::alloc::details::hooked_delete(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept {
+    preFIX::alloc::details::hooked_delete(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept {
+    preFIX::alloc::details::hooked_delete(ptr); }
+
+void operator delete(void* ptr, std::nothrow_t const&) noexcept {
+    preFIX::alloc::details::hooked_delete(ptr); }
+
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept {
+    preFIX::alloc::details::hooked_delete(ptr); }
+
+#endif
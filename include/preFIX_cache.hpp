@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstring>
+#include <vector>
+
+#include <preFIX.hpp>
+#include <preFIX_dict.hpp>
+
+namespace preFIX { namespace dict {
+    
+    /**
+     * msg_t keeping its last encoding: set<>()/clear<>()/modify<>() mark fields
+     * as dirty, serialize() re-encodes only dirty fields (tail is shifted
+     * only if field's width has changed) and copies cached bytes.
+     * Bytes sum is updated incrementally => CheckSum costs O(header).
+     * msg_t base is private and at<>() is read-only, so fields can't be
+     * changed behind the cache (e.g. through reference kept across serialize()).
+     */
+    template <typename... T>
+    class cached_msg_t : private msg_t<T...> {
+    private:
+        using base = msg_t<T...>;
+        using tuple_t = std::tuple<T...>;
+        using encode_fn = bool (*)(base const&, write_cursor&);
+        
+        enum : size_t { fields = sizeof...(T) };
+        
+        template <typename U>
+        static bool encode(base const& msg, write_cursor& dst) {
+            return msg.template at<U>().serialize(dst); }
+        
+        static std::array<encode_fn, fields> const& encoders() {
+            static const std::array<encode_fn, fields> arr = {{ &encode<T>... }};
+            return arr;
+        }
+        
+        template <typename U>
+        void touch() {
+            dirty_.set(details::idx_of<tuple_t, U>::value); }
+        
+        template <typename U>
+        void sync_length(std::false_type) {}
+        
+        /// Length field of Data is re-encoded together with it
+        template <typename U>
+        void sync_length(std::true_type) {
+            using length_field = typename U::length_field;
+            touch<length_field>();
+            base::template at<length_field>().value = Int_underlying(base::template at<U>().value.size());
+        }
+        
+        mutable std::vector<char> bytes_;
+        mutable std::vector<char> scratch_;
+        mutable std::array<int, fields + 1> offsets_;  // field i: [offsets_[i], offsets_[i+1])
+        mutable std::bitset<fields> dirty_;
+        mutable bool valid_ = false;
+        mutable int sum_ = 0;
+        mutable size_t reencoded_ = 0;
+        
+        /// Encodes i-th field to scratch_, @returns encoded size
+        int encode_field(size_t i) const {
+            if(scratch_.empty())
+                scratch_.resize(256);
+            
+            for(;;) {
+                write_cursor wc(scratch_.data(), scratch_.size());
+                if(encoders()[i](*this, wc))
+                    return wc.processed();
+                scratch_.resize(scratch_.size()*2);
+            }
+        }
+        
+        void rebuild() const {
+            bytes_.clear();
+            for(size_t i = 0; i < fields; ++i) {
+                int size = encode_field(i);
+                offsets_[i] = bytes_.size();
+                bytes_.insert(bytes_.end(), scratch_.data(), scratch_.data() + size);
+            }
+            offsets_[fields] = bytes_.size();
+            
+            sum_ = sum_bytes(bytes_.data(), bytes_.size());
+            reencoded_ += fields;
+            dirty_.reset();
+            valid_ = true;
+        }
+        
+        void update(size_t i) const {
+            int size = encode_field(i);
+            int old_begin = offsets_[i];
+            int old_size  = offsets_[i + 1] - old_begin;
+            int delta = size - old_size;
+            
+            sum_ -= sum_bytes(bytes_.data() + old_begin, old_size);
+            
+            if(delta != 0) {
+                int tail = int(bytes_.size()) - (old_begin + old_size);
+                if(delta > 0)
+                    bytes_.resize(bytes_.size() + delta);
+                std::memmove(bytes_.data() + old_begin + size,
+                    bytes_.data() + old_begin + old_size, tail);
+                if(delta < 0)
+                    bytes_.resize(bytes_.size() + delta);
+                
+                for(size_t j = i + 1; j <= fields; ++j)
+                    offsets_[j] += delta;
+            }
+            
+            std::memcpy(bytes_.data() + old_begin, scratch_.data(), size);
+            sum_ += sum_bytes(scratch_.data(), size);
+            ++reencoded_;
+        }
+        
+        /// Brings cached encoding up to date
+        void refresh() const {
+            if(!valid_)
+                return rebuild();
+            
+            if(dirty_.any())
+                for(size_t i = 0; i < fields; ++i)
+                    if(dirty_[i])
+                        update(i);
+            dirty_.reset();
+        }
+    
+    public:
+        /// Read-only access, use set<>()/clear<>()/modify<>() to change fields
+        template <typename U>
+        inline U const& at() const {
+            return base::template at<U>(); }
+        
+        template <typename U, typename Arg>
+        cached_msg_t& set(Arg&& arg) {
+            return modify<U>([&](U& field) {
+                field.value = std::forward<Arg>(arg); });
+        }
+        
+        template <typename U>
+        void clear() {
+            modify<U>([](U& field) {
+                field.clear(); });
+        }
+        
+        /// Scoped mutable access (e.g. to group entries): f(field) is called, field is marked dirty
+        template <typename U, typename F>
+        cached_msg_t& modify(F&& f) {
+            touch<U>();
+            std::forward<F>(f)(base::template at<U>());
+            sync_length<U>(details::is_data<U>{});
+            return *this;
+        }
+        
+        template <typename F>
+        void for_each(F&& f) const {
+            base::for_each(std::forward<F>(f)); }
+        
+        /// Mutable visiting invalidates whole encoding
+        template <typename F>
+        void for_each(F&& f) {
+            invalidate();
+            base::for_each(std::forward<F>(f));
+        }
+        
+        /// Drops cached encoding completely
+        void invalidate() {
+            valid_ = false; }
+        
+        /// Copies (re-encoding dirty fields) cached bytes to given buffer
+        bool serialize(write_cursor& dst) const {
+            refresh();
+            
+            int size = bytes_.size();
+            if(dst.left() < size)
+                return false;
+            
+            std::memcpy(dst.pointer(), bytes_.data(), size);
+            dst.step(size);
+            return true;
+        }
+        
+        bool deserialize(read_cursor& src) {
+            invalidate();
+            return base::deserialize(src);
+        }
+        
+        /// Sum of encoded bytes (for CheckSum)
+        int byte_sum() const {
+            refresh();
+            return sum_;
+        }
+        
+        /// Encoded size
+        int encoded_size() const {
+            refresh();
+            return bytes_.size();
+        }
+        
+        /// Number of fields encodings performed so far (statistics)
+        size_t reencoded() const {
+            return reencoded_; }
+    };
+    
+    
+    /// serialize_message() overload: CheckSum sums header bytes only
+    template <typename H, typename... B, typename T>
+    bool serialize_message(write_cursor& dst, H& header, cached_msg_t<B...> const& msg, T& trailer) {
+        char* begin = dst.pointer();
+        
+        if(!details::serialize_body(dst, header, msg))
+            return false;
+        
+        char* body = dst.pointer() - msg.encoded_size();
+        int sum = msg.byte_sum() + sum_bytes(begin, body - begin);
+        
+        trailer.template set<CheckSum>(sum % 256);
+        return trailer.serialize(dst);
+    }
+
+} // dict
+} // preFIX
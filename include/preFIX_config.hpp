@@ -47,32 +47,302 @@ namespace preFIX { namespace types { namespace details {
             }
         };
         
-        /// Special serializer for fixed-width integer: 9=000123<SOH>
+        /// Special serializer for fixed-width integer: 9=000123<SOH> (no allocations)
         template <size_t Width>
         struct fixed_width_int_serializer {
             template <typename U>
             static bool serialize(write_cursor& dst, U&& value, char delimiter = SOH) {
                 bool neg = (value < 0);
-                std::ostringstream ss;
-                ss << (neg ? "-" : "")
-                    << std::setfill('0')
-                    << std::setw(Width - neg)
-                    << std::abs(std::forward<U>(value))
-                    << delimiter;
-                std::string str = ss.str();
+                std::uint64_t abs = neg ? ~std::uint64_t(value) + 1 : std::uint64_t(value);
                 
-                int need = str.size();
-                if(dst.left() >= need) {
-                    std::memcpy(dst.pointer(), str.data(), str.size());
-                    dst.step(need);
-                    return true;
-                }
+                int digits = 1;
+                for(std::uint64_t v = abs; v >= 10; v /= 10)
+                    ++digits;
+                int width = std::max(int(Width) - int(neg), digits);
                 
-                return false;
+                int need = int(neg) + width + 1;
+                if(dst.left() < need)
+                    return false;
+                
+                char* ptr = dst.pointer();
+                if(neg)
+                    *ptr++ = '-';
+                for(int i = width - 1; i >= 0; --i, abs /= 10)
+                    ptr[i] = char('0' + abs%10);
+                ptr[width] = delimiter;
+                dst.step(need);
+                return true;
             }
         };
         
     } // defaults
+    
+    
+    /// ------------------------! UTC date/time !------------------------ ///
+    
+    /// Date/time S/D, values are integers counted from the Unix epoch
+    namespace chrono {
+        
+        constexpr Time_underlying pow10(int n) {
+            return n == 0 ? 1 : 10*pow10(n - 1); }
+        
+        /// Floor division (correct for values before the epoch)
+        constexpr Time_underlying floor_div(Time_underlying a, Time_underlying b) {
+            return (a >= 0 ? a : a - b + 1)/b; }
+        
+        /// Days since 1970-01-01 => civil date, H. Hinnant's algorithm
+        inline void civil_from_days(Time_underlying z, int& y, int& m, int& d) {
+            z += 719468;
+            Time_underlying era = (z >= 0 ? z : z - 146096)/146097;
+            unsigned doe = unsigned(z - era*146097);
+            unsigned yoe = (doe - doe/1460 + doe/36524 - doe/146096)/365;
+            unsigned doy = doe - (365*yoe + yoe/4 - yoe/100);
+            unsigned mp  = (5*doy + 2)/153;
+            d = int(doy - (153*mp + 2)/5 + 1);
+            m = int(mp < 10 ? mp + 3 : mp - 9);
+            y = int(Time_underlying(yoe) + era*400 + (m <= 2));
+        }
+        
+        /// Civil date => days since 1970-01-01
+        inline Time_underlying days_from_civil(int y, int m, int d) {
+            y -= (m <= 2);
+            Time_underlying era = (y >= 0 ? y : y - 399)/400;
+            unsigned yoe = unsigned(y - era*400);
+            unsigned doy = (153*(m + (m > 2 ? -3 : 9)) + 2)/5 + d - 1;
+            unsigned doe = yoe*365 + yoe/4 - yoe/100 + doy;
+            return era*146097 + Time_underlying(doe) - 719468;
+        }
+        
+        /// Writes value as exactly `width` digits (leading zeros)
+        inline void write_digits(char* dst, Time_underlying value, int width) {
+            for(int i = width - 1; i >= 0; --i, value /= 10)
+                dst[i] = char('0' + value%10);
+        }
+        
+        /// Parses exactly `width` digits, sets `bad` if non-digit met
+        inline Time_underlying read_digits(char const* src, int width, unsigned& bad) {
+            Time_underlying value = 0;
+            for(int i = 0; i < width; ++i) {
+                unsigned digit = unsigned(src[i]) - '0';
+                bad |= (digit > 9);
+                value = 10*value + digit;
+            }
+            return value;
+        }
+        
+        /// "YYYYMMDD" <=> days, last converted date is cached
+        struct date_cache {
+            Time_underlying days = std::numeric_limits<Time_underlying>::min();
+            char text[8];
+            
+            void format(Time_underlying new_days) {
+                if(new_days != days) {
+                    int y, m, d;
+                    civil_from_days(new_days, y, m, d);
+                    write_digits(text + 0, y, 4);
+                    write_digits(text + 4, m, 2);
+                    write_digits(text + 6, d, 2);
+                    days = new_days;
+                }
+            }
+            
+            bool parse(char const* src, Time_underlying& result) {
+                if(days == std::numeric_limits<Time_underlying>::min() || std::memcmp(src, text, 8) != 0) {
+                    unsigned bad = 0;
+                    int y = int(read_digits(src + 0, 4, bad));
+                    int m = int(read_digits(src + 4, 2, bad));
+                    int d = int(read_digits(src + 6, 2, bad));
+                    if(bad || m < 1 || m > 12 || d < 1 || d > 31)
+                        return false;
+                    
+                    // Day beyond month's length (e.g. Feb 30) doesn't round-trip
+                    Time_underlying parsed = days_from_civil(y, m, d);
+                    int cy, cm, cd;
+                    civil_from_days(parsed, cy, cm, cd);
+                    if(cy != y || cm != m || cd != d)
+                        return false;
+                    std::memcpy(text, src, 8);
+                    days = parsed;
+                }
+                result = days;
+                return true;
+            }
+        };
+        
+        /// Writes "HH:MM:SS[.fff]" (fraction of `Digits` digits)
+        template <int Digits>
+        inline char* format_time(char* ptr, Time_underlying units_of_day) {
+            constexpr Time_underlying ups = pow10(Digits);
+            Time_underlying secs = units_of_day/ups;
+            write_digits(ptr + 0, secs/3600, 2);    ptr[2] = ':';
+            write_digits(ptr + 3, secs/60%60, 2);   ptr[5] = ':';
+            write_digits(ptr + 6, secs%60, 2);
+            ptr += 8;
+            if(Digits > 0) {
+                *ptr = '.';
+                write_digits(ptr + 1, units_of_day%ups, Digits);
+                ptr += 1 + Digits;
+            }
+            return ptr;
+        }
+        
+        /**
+         * Parses "HH:MM:SS[.f...]" up to `end`, fraction of any length (<= 9)
+         * is scaled to `Digits` precision. @returns false on malformed input
+         */
+        template <int Digits>
+        inline bool parse_time(char const* ptr, char const* end, Time_underlying& units_of_day) {
+            constexpr Time_underlying ups = pow10(Digits);
+            if(end - ptr < 8)
+                return false;
+            
+            unsigned bad = (ptr[2] != ':') | (ptr[5] != ':');
+            Time_underlying h = read_digits(ptr + 0, 2, bad);
+            Time_underlying m = read_digits(ptr + 3, 2, bad);
+            Time_underlying s = read_digits(ptr + 6, 2, bad);
+            bad |= (h > 23) | (m > 59) | (s > 60);
+            
+            Time_underlying frac = 0;
+            int width = int(end - ptr) - 9;
+            if(width >= 0) {
+                bad |= (ptr[8] != '.') | (width == 0) | (width > 9);
+                if(!bad) {
+                    frac = read_digits(ptr + 9, width, bad);
+                    frac = width > Digits ?
+                        frac/pow10(width - Digits) :
+                        frac*pow10(Digits - width);
+                }
+            }
+            
+            units_of_day = (h*3600 + m*60 + s)*ups + frac;
+            return !bad;
+        }
+        
+        /// UTCTimestamp: "YYYYMMDD-HH:MM:SS[.fff]", value = 10^-Digits s since epoch
+        template <int Digits>
+        struct utc_timestamp_serializer {
+            static_assert(Digits >= 0 && Digits <= 9, "unsupported precision");
+            
+            /**
+             * "YYYYMMDD-HH:MM:" is cached per thread and rewritten only
+             * when minute changes, rest is written digit by digit
+             */
+            static bool serialize(write_cursor& dst, Time_underlying value, char delimiter = SOH) {
+                constexpr Time_underlying ups = pow10(Digits);
+                constexpr int need = 17 + (Digits > 0 ? 1 + Digits : 0) + 1;
+                if(dst.left() < need)
+                    return false;
+                
+                struct minute_cache {
+                    Time_underlying minute = std::numeric_limits<Time_underlying>::min();
+                    char prefix[15];
+                };
+                static thread_local minute_cache cache;
+                
+                Time_underlying secs   = floor_div(value, ups);
+                Time_underlying frac   = value - secs*ups;
+                Time_underlying minute = floor_div(secs, 60);
+                
+                if(minute != cache.minute) {
+                    date_cache date;
+                    date.format(floor_div(minute, 24*60));
+                    std::memcpy(cache.prefix, date.text, 8);
+                    
+                    Time_underlying mod = minute - floor_div(minute, 24*60)*24*60;
+                    cache.prefix[8] = '-';
+                    write_digits(cache.prefix + 9, mod/60, 2);
+                    cache.prefix[11] = ':';
+                    write_digits(cache.prefix + 12, mod%60, 2);
+                    cache.prefix[14] = ':';
+                    cache.minute = minute;
+                }
+                
+                char* ptr = dst.pointer();
+                std::memcpy(ptr, cache.prefix, 15);
+                write_digits(ptr + 15, secs - minute*60, 2);
+                if(Digits > 0) {
+                    ptr[17] = '.';
+                    write_digits(ptr + 18, frac, Digits);
+                }
+                ptr[need - 1] = delimiter;
+                dst.step(need);
+                return true;
+            }
+        };
+        
+        template <int Digits>
+        struct utc_timestamp_deserializer {
+            static bool deserialize(read_cursor& src, Time_underlying& value, char delimiter = SOH) {
+                auto ptr = src.pointer();
+                auto end = ptr + src.left();
+                auto fnd = std::find(ptr, end, delimiter);
+                if(fnd == end || fnd - ptr < 17 || ptr[8] != '-')
+                    return false;
+                
+                static thread_local date_cache date;
+                Time_underlying days, units_of_day;
+                if(!date.parse(ptr, days) || !parse_time<Digits>(ptr + 9, fnd, units_of_day))
+                    return false;
+                
+                value = days*24*3600*pow10(Digits) + units_of_day;
+                src.step(fnd - ptr + 1);
+                return true;
+            }
+        };
+        
+        /// UTCDateOnly: "YYYYMMDD", value = days since epoch
+        struct utc_date_serializer {
+            static bool serialize(write_cursor& dst, Time_underlying value, char delimiter = SOH) {
+                if(dst.left() < 9)
+                    return false;
+                date_cache date;
+                date.format(value);
+                std::memcpy(dst.pointer(), date.text, 8);
+                dst.pointer()[8] = delimiter;
+                dst.step(9);
+                return true;
+            }
+        };
+        
+        struct utc_date_deserializer {
+            static bool deserialize(read_cursor& src, Time_underlying& value, char delimiter = SOH) {
+                if(src.left() < 9 || src.pointer()[8] != delimiter)
+                    return false;
+                date_cache date;
+                if(!date.parse(src.pointer(), value))
+                    return false;
+                src.step(9);
+                return true;
+            }
+        };
+        
+        /// UTCTimeOnly: "HH:MM:SS[.fff]", value = 10^-Digits s since midnight
+        template <int Digits>
+        struct utc_time_serializer {
+            static bool serialize(write_cursor& dst, Time_underlying value, char delimiter = SOH) {
+                constexpr int need = 8 + (Digits > 0 ? 1 + Digits : 0) + 1;
+                if(dst.left() < need)
+                    return false;
+                *format_time<Digits>(dst.pointer(), value) = delimiter;
+                dst.step(need);
+                return true;
+            }
+        };
+        
+        template <int Digits>
+        struct utc_time_deserializer {
+            static bool deserialize(read_cursor& src, Time_underlying& value, char delimiter = SOH) {
+                auto ptr = src.pointer();
+                auto end = ptr + src.left();
+                auto fnd = std::find(ptr, end, delimiter);
+                if(fnd == end || !parse_time<Digits>(ptr, fnd, value))
+                    return false;
+                src.step(fnd - ptr + 1);
+                return true;
+            }
+        };
+    
+    } // chrono
 
     
     /// ------------------------! Tiltower Customs Inc. !------------------------ ///
@@ -127,6 +397,9 @@ namespace preFIX { namespace types { namespace details {
         struct custom_serializer {
             
             static bool serialize(write_cursor& dst, Char_underlying value, char delimiter = SOH) {
+                if(dst.left() < 2)
+                    return false;
+                
                 auto ptr = dst.pointer();
                 ptr[0] = value;
                 ptr[1] = delimiter;
@@ -135,6 +408,11 @@ namespace preFIX { namespace types { namespace details {
             }
             
             static bool serialize(write_cursor& dst, Int_underlying value, char delimiter = SOH) {
+                uint64_t abs = value < 0 ? ~uint64_t(value) + 1 : uint64_t(value);
+                int need = int(digits(abs)) + (value < 0) + 1;
+                if(dst.left() < need)
+                    return false;
+                
                 auto ptr = dst.pointer();
                 //auto written = std::sprintf(ptr, "%ld", long(value));
                 auto written = itoa(ptr, long(value));
@@ -145,17 +423,24 @@ namespace preFIX { namespace types { namespace details {
             
             static bool serialize(write_cursor& dst, Float_underlying value, char delimiter = SOH) {
                 auto ptr = dst.pointer();
-                auto written = std::sprintf(ptr, "%lf", double(value));
+                auto written = std::snprintf(ptr, dst.left(), "%lf", double(value));
+                if(written < 0 || written + 1 > dst.left())
+                    return false;
+                
                 ptr[written] = delimiter;
                 dst.step(written + 1);
                 return true;
             }
             
             static bool serialize(write_cursor& dst, String_underlying const& value, char delimiter = SOH) {
+                int need = int(value.size()) + 1;
+                if(dst.left() < need)
+                    return false;
+                
                 auto ptr = dst.pointer();
                 std::memcpy(ptr, value.data(), value.size());
                 ptr[value.size()] = delimiter;
-                dst.step(value.size() + 1);
+                dst.step(need);
                 return true;
             }
         };
@@ -175,6 +460,21 @@ namespace preFIX { namespace types { namespace details {
     template <size_t Width>
     using fixed_width_int_serializer = defaults::fixed_width_int_serializer<Width>;
 
+    template <int Digits>
+    using utc_timestamp_serializer   = chrono::utc_timestamp_serializer<Digits>;
+    
+    template <int Digits>
+    using utc_timestamp_deserializer = chrono::utc_timestamp_deserializer<Digits>;
+    
+    using utc_date_serializer   = chrono::utc_date_serializer;
+    using utc_date_deserializer = chrono::utc_date_deserializer;
+    
+    template <int Digits>
+    using utc_time_serializer   = chrono::utc_time_serializer<Digits>;
+    
+    template <int Digits>
+    using utc_time_deserializer = chrono::utc_time_deserializer<Digits>;
+
 } // details
 } // types
 } // preFIX
@@ -2,9 +2,11 @@
 
 #include <array>
 #include <bitset>
+#include <cstdio>
 #include <list>
 #include <map>
 #include <numeric>
+#include <string>
 #include <tuple>
 #include <unordered_set>
 #include <unordered_map>
@@ -16,20 +18,110 @@ namespace preFIX { namespace dict {
     
     using namespace preFIX::types;
     
+    /**
+     * Marks field as hot: hot fields are placed at the beginning of msg_t
+     * storage (first cache line), order of at<>()/serialization is kept.
+     *   namespace preFIX { namespace dict {
+     *       template <> struct hot_field<Price> : std::true_type {};
+     *   }}
+     */
+    template <typename T>
+    struct hot_field : std::false_type {};
+    
     namespace details {
+        /// Index of T inside V... (sizeof...(V) if absent), single instantiation per lookup
+        template <typename T, typename... V>
+        constexpr size_t type_index() {
+            constexpr bool same[] = { std::is_same<T, V>::value..., false };
+            for(size_t i = 0; i < sizeof...(V); ++i)
+                if(same[i])
+                    return i;
+            return sizeof...(V);
+        }
+        
         /// Contains index of type inside tuple-like class
         template <typename tuple, typename T>
         struct idx_of;
         
-        template <template <class...> class tuple, typename T>
-        struct idx_of<tuple<>, T> : std::integral_constant<size_t, 0> {
-            static_assert(!sizeof(T), "can't find type"); };
-        
         template <template <class...> class tuple, typename T, typename... V>
-        struct idx_of<tuple<T, V...>, T> : std::integral_constant<size_t, 0> {};
+        struct idx_of<tuple<V...>, T> : std::integral_constant<size_t, type_index<T, V...>()> {
+            static_assert(type_index<T, V...>() != sizeof...(V), "can't find type"); };
+        
+        /// Storage element of msg_t, indexed to keep bases distinct
+        template <size_t I, typename T>
+        struct field_leaf {
+            T value; };
+        
+        /// O(1) type lookup by index: I-th type is deduced from base class
+        template <size_t I, typename T>
+        struct indexed_type {};
+        
+        template <typename Idx, typename... T>
+        struct indexed_pack;
+        
+        template <size_t... I, typename... T>
+        struct indexed_pack<std::index_sequence<I...>, T...> : indexed_type<I, T>... {};
+        
+        template <size_t I, typename T>
+        T* type_at_impl(indexed_type<I, T> const*);
+        
+        template <size_t I, typename Pack>
+        using type_at = std::remove_pointer_t<decltype(type_at_impl<I>(static_cast<Pack const*>(nullptr)))>;
+        
+        /// Storage position key: hot fields first, then by alignment (descending), then declaration order
+        template <size_t I, typename T>
+        constexpr int layout_key() {
+            return (hot_field<T>::value ? 0 : 1 << 30) |
+                   (int(4096 - (alignof(T) < 4096 ? alignof(T) : 4096)) << 16) | int(I);
+        }
+        
+        /// Declaration indexes in storage order
+        template <typename Idx, typename... T>
+        struct layout_order;
+        
+        template <size_t... I, typename... T>
+        struct layout_order<std::index_sequence<I...>, T...> {
+            static_assert(sizeof...(T) < (1 << 16), "too many fields");
+            using sorted = preFIX::details::sorted_keys<layout_key<I, T>()...>;
+            using type = std::index_sequence<size_t(sorted::value[I] & 0xFFFF)...>;
+        };
+        
+        template <typename Order, typename Pack>
+        struct ordered_storage;
+        
+        template <size_t... P, typename Pack>
+        struct ordered_storage<std::index_sequence<P...>, Pack> : field_leaf<P, type_at<P, Pack>>... {};
+        
+        /**
+         * Flat tuple replacement: one base per field instead of recursive
+         * std::tuple, field is found by deduction (no index lookup).
+         * Bases are laid out in layout_order (leaf index is still the
+         * declaration one => iteration order doesn't change).
+         */
+        template <typename Idx, typename... T>
+        struct field_storage;
+        
+        template <size_t... I, typename... T>
+        struct field_storage<std::index_sequence<I...>, T...> : ordered_storage<
+            typename layout_order<std::index_sequence<I...>, T...>::type,
+            indexed_pack<std::index_sequence<I...>, T...>
+        > {};
+        
+        template <size_t I, typename T>
+        inline T const& leaf_at(field_leaf<I, T> const& leaf) {
+            return leaf.value; }
+        
+        template <size_t I, typename T>
+        inline T& leaf_at(field_leaf<I, T>& leaf) {
+            return leaf.value; }
         
-        template <template <class...> class tuple, typename T, typename U, typename... V>
-        struct idx_of<tuple<U, V...>, T> : std::integral_constant<size_t, (1 + idx_of<tuple<V...>, T>::value)> {};
+        template <typename T, size_t I>
+        inline T const& leaf_of(field_leaf<I, T> const& leaf) {
+            return leaf.value; }
+        
+        template <typename T, size_t I>
+        inline T& leaf_of(field_leaf<I, T>& leaf) {
+            return leaf.value; }
         
     } // details
     
@@ -59,6 +151,7 @@ namespace preFIX { namespace dict {
             return !value.empty(); }
         
         virtual bool serialize(write_cursor& dst) const override {
+            PREFIX_STATS_SERIALIZE(Group, dst);
             Int group_size(value.size());
             if(group_size.serialize(dst)) {
                 for(auto const& msg : value)
@@ -70,6 +163,7 @@ namespace preFIX { namespace dict {
         }
         
         virtual bool deserialize(read_cursor& src) override {
+            PREFIX_STATS_DESERIALIZE(Group, src);
             Int group_size;
             if(group_size.deserialize(src)) {
                 resize(group_size.value);
@@ -83,8 +177,13 @@ namespace preFIX { namespace dict {
         
         /// ------------------------! Group interface !------------------------ ///
         
+        /// All entries are null after resize, existing ones are reset in place (keeping capacity)
         Group& resize(size_t new_size) {
-            clear();
+            PREFIX_STATS_ADD(Group, allocations, new_size > value.capacity());
+            size_t kept = std::min(new_size, value.size());
+            for(size_t i = 0; i < kept; ++i)
+                value[i].for_each([](auto& field) {
+                    field.clear(); });
             value.resize(new_size);
             return *this;
         }
@@ -96,6 +195,173 @@ namespace preFIX { namespace dict {
             return value[idx]; }
     };
     
+    /// Non-owning view of raw bytes, valid while underlying buffer lives
+    class data_view {
+    private:
+        char const* data_ = nullptr;
+        size_t size_ = 0;
+    
+    public:
+        data_view() = default;
+        data_view(char const* data, size_t size) : data_(data), size_(size) {}
+        data_view(std::string const& str) : data_(str.data()), size_(str.size()) {}
+        
+        inline char const* data() const {
+            return data_; }
+        
+        inline size_t size() const {
+            return size_; }
+        
+        void assign(char const* data, size_t size) {
+            data_ = data;
+            size_ = size;
+        }
+        
+        std::string str() const {
+            return std::string(data_, size_); }
+        
+        bool operator==(data_view const& other) const {
+            return size_ == other.size_ && (size_ == 0 || std::memcmp(data_, other.data_, size_) == 0); }
+        
+        bool operator!=(data_view const& other) const {
+            return !(*this == other); }
+    };
+    
+    /**
+     * FIX "data" value (RawData, XmlData, EncodedText...) bound to its
+     * length field, which must precede it in the same msg_t or group entry.
+     * Value may contain SOH: exactly Length bytes are taken with one bounds
+     * check, copied (std::string) or referenced in source buffer (data_view).
+     * msg_t::set<>() updates the length field too.
+     *   using RawDataLength = field_base<95, Int>;
+     *   using RawData       = field_base<96, Data<RawDataLength>>;
+     */
+    template <typename LengthField, typename Underlying = std::string>
+    struct Data : fix_value_base {
+        using length_field = LengthField;
+        using underlying_type = Underlying;
+        
+        underlying_type value;
+        
+        Data() = default;
+        Data(Data const& other) : value(other.value) {}
+        
+        /// Binding belongs to enclosing msg_t and isn't copied
+        Data& operator=(Data const& other) {
+            value = other.value;
+            return *this;
+        }
+        
+        void clear() {
+            value = underlying_type(); }
+        
+        bool present() const {
+            return value.size() != 0; }
+        
+        virtual bool serialize(write_cursor& dst) const override {
+            PREFIX_STATS_SERIALIZE(Data, dst);
+            int need = int(value.size()) + 1;
+            if(dst.left() < need)
+                return false;
+            
+            std::memcpy(dst.pointer(), value.data(), value.size());
+            dst.pointer()[value.size()] = SOH;
+            dst.step(need);
+            return true;
+        }
+        
+        /// Fails if length field wasn't parsed before (set by msg_t)
+        virtual bool deserialize(read_cursor& src) override {
+            PREFIX_STATS_DESERIALIZE(Data, src);
+            Int_underlying const* length = length_;
+            length_ = nullptr;
+            
+            if(!length || *length < 0 || *length >= src.left() || src.pointer()[*length] != SOH) {
+                PREFIX_STATS_ADD(Data, failures, 1);
+                return false;
+            }
+            
+            PREFIX_STATS_ONLY(auto capacity = stats::capacity_of(value);)
+            value.assign(src.pointer(), size_t(*length));
+            PREFIX_STATS_ADD(Data, allocations, stats::capacity_of(value) > capacity);
+            src.step(int(*length) + 1);
+            return true;
+        }
+    
+    private:
+        template <typename...>
+        friend class msg_t;
+        
+        Int_underlying const* length_ = nullptr;
+    };
+    
+    /// Zero-copy Data: value points into deserialized buffer
+    template <typename LengthField>
+    using DataView = Data<LengthField, data_view>;
+    
+    namespace details {
+        template <typename L, typename U>
+        std::true_type data_test(Data<L, U> const*);
+        std::false_type data_test(...);
+        
+        /// Field holding Data<>
+        template <typename F>
+        using is_data = decltype(data_test(static_cast<F const*>(nullptr)));
+        
+        template <typename F>
+        constexpr int length_tag(std::true_type) {
+            return F::length_field::tag; }
+        
+        template <typename F>
+        constexpr int length_tag(std::false_type) {
+            return 0; }
+        
+        template <typename F, typename... T>
+        constexpr size_t length_index(std::true_type) {
+            return type_index<typename F::length_field, T...>(); }
+        
+        template <typename F, typename... T>
+        constexpr size_t length_index(std::false_type) {
+            return 0; }
+        
+        /// Every Data field has its length field declared before it
+        template <typename... T>
+        constexpr bool lengths_precede() {
+            constexpr bool data[] = { is_data<T>::value..., false };
+            constexpr size_t idx[] = { length_index<T, T...>(is_data<T>{})..., 0 };
+            for(size_t i = 0; i < sizeof...(T); ++i)
+                if(data[i] && idx[i] >= i)
+                    return false;
+            return true;
+        }
+        
+        /// Fills length tag of Data field (at idx_map position)
+        template <typename F, typename IdxMap, size_t N>
+        void store_length_tag(std::array<int, N>& tags) {
+            tags[IdxMap::idx_of(F::tag)] = length_tag<F>(is_data<F>{}); }
+        
+        template <typename F, typename IdxMap>
+        void store_length_tag(std::array<int, 0>&) {}
+        
+        /// Data field at idx is met before its length field
+        template <typename IdxMap, size_t N, typename Found>
+        bool length_missing(std::array<int, N> const& tags, int idx, Found const& found) {
+            return tags[idx] != 0 && !found[IdxMap::idx_of(tags[idx])]; }
+        
+        template <typename IdxMap, typename Found>
+        bool length_missing(std::array<int, 0> const&, int, Found const&) {
+            return false; }
+        
+        template <typename... T>
+        constexpr bool any_data() {
+            constexpr bool data[] = { is_data<T>::value..., false };
+            for(size_t i = 0; i < sizeof...(T); ++i)
+                if(data[i])
+                    return true;
+            return false;
+        }
+    } // details
+    
     /**
      * Base class for all fields. T requirements:
      * - t.value (optional, instantiates on demand)
@@ -130,24 +396,60 @@ namespace preFIX { namespace dict {
     template <typename... T>
     class msg_t {
     private:
-        using tuple_t = std::tuple<T...>;
-        tuple_t fields_;
+        static_assert(preFIX::details::ct_unique(preFIX::details::sorted_keys<(T::tag)...>::value), "duplicate tags inside msg_t");
+        static_assert(details::lengths_precede<T...>(), "length field of Data must precede it in the same msg_t");
+        
+        using storage_t = details::field_storage<std::index_sequence_for<T...>, T...>;
+        storage_t fields_;
         
-        template <typename U, size_t idx = details::idx_of<tuple_t, U>::value>
+        template <typename U>
         inline U const& get_field() const {
-            return std::get<idx>(fields_); }
+            return details::leaf_of<U>(fields_); }
         
-        template <typename U, size_t idx = details::idx_of<tuple_t, U>::value>
+        template <typename U>
         inline U& get_field() {
-            return std::get<idx>(fields_); }
+            return details::leaf_of<U>(fields_); }
+        
+        /// Iterates by position, no per-field type lookup
+        template <typename F, size_t... I>
+        void for_each_impl(F& f, std::index_sequence<I...>) const {
+            using filler = const int[sizeof...(T) + 1];
+            (void)filler{(f(details::leaf_at<I>(fields_)), 0)..., 0};
+        }
+        
+        template <typename F, size_t... I>
+        void for_each_impl(F& f, std::index_sequence<I...>) {
+            using filler = const int[sizeof...(T) + 1];
+            (void)filler{(f(details::leaf_at<I>(fields_)), 0)..., 0};
+        }
+        
+        template <typename U>
+        void bind_length(U&, std::false_type) {}
+        
+        template <typename U>
+        void bind_length(U& field, std::true_type) {
+            field.length_ = &get_field<typename U::length_field>().value; }
+        
+        template <typename U>
+        void sync_length(std::false_type) {}
+        
+        template <typename U>
+        void sync_length(std::true_type) {
+            get_field<typename U::length_field>().value = Int_underlying(get_field<U>().value.size()); }
         
         bool deserialize_impl(read_cursor& src) {
             using idx_map = preFIX::details::index_map<(T::tag)...>;
-            using filler = const int[sizeof...(T)];
+            enum : bool { has_data = details::any_data<T...>() };
             
             std::bitset<sizeof...(T)> found_idxes{};
             std::array<fix_value_base*, sizeof...(T)> ptrs_arr;
-            (void)filler{(ptrs_arr[idx_map::idx_of(T::tag)] = &get_field<T>(), 0)...};
+            std::array<int, has_data ? sizeof...(T) : 0> length_tags;
+            for_each([this, &ptrs_arr, &length_tags](auto& field) {
+                using field_t = std::decay_t<decltype(field)>;
+                ptrs_arr[idx_map::idx_of(field_t::tag)] = &field;
+                this->bind_length(field, details::is_data<field_t>{});
+                details::store_length_tag<field_t, idx_map>(length_tags);
+            });
             
             while(src.left() > 0) {
                 // Here we have unread data
@@ -163,12 +465,15 @@ namespace preFIX { namespace dict {
                 // If tag is belonging to msg
                 if(idx != idx_map::size && !found_idxes[idx]) {
                     found_idxes[idx].flip();
+                    if(has_data && details::length_missing<idx_map>(length_tags, idx, found_idxes))
+                        return false;
                     auto value_ptr = ptrs_arr[idx];
                     if(!value_ptr->deserialize(src))
                         return false;
                 
                 // If tag has repeated or doesn't belong to msg
                 } else {
+                    PREFIX_STATS_ADD(msg_t, unknown_tags, idx == idx_map::size);
                     src.step(src.left() - left); // step backward
                     break;
                 }
@@ -186,17 +491,20 @@ namespace preFIX { namespace dict {
         inline U& at() {
             return get_field<U>(); }
         
-        /// Assigns given value to field's data
+        /// Assigns given value to field's data (and size to length field of Data)
         template <typename U, typename Arg>
         msg_t& set(Arg&& arg) {
             at<U>().value = std::forward<Arg>(arg);
+            sync_length<U>(details::is_data<U>{});
             return *this;
         }
         
         /// Set field to null == omitting during serialization
         template <typename U>
         void clear() {
-            at<U>().clear(); }
+            at<U>().clear();
+            sync_length<U>(details::is_data<U>{});
+        }
         
         /// Extracts value from field
         template <typename U, typename Arg>
@@ -206,15 +514,97 @@ namespace preFIX { namespace dict {
         }
         
         
+        /// Calls f(field) for every field in declaration order
+        template <typename F>
+        void for_each(F&& f) const {
+            for_each_impl(f, std::index_sequence_for<T...>{}); }
+        
+        template <typename F>
+        void for_each(F&& f) {
+            for_each_impl(f, std::index_sequence_for<T...>{}); }
+        
+        
         /// Recursively serializes fields to given buffer
         bool serialize(write_cursor& dst) const {
-            bool res[] = {(get_field<T>().serialize(dst))...};
-            return std::accumulate(std::begin(res), std::end(res), 0) == sizeof...(T);
+            PREFIX_STATS_SERIALIZE(msg_t, dst);
+            size_t res = 0;
+            for_each([&](auto const& field) {
+                res += field.serialize(dst); });
+            return res == sizeof...(T);
         }
         
         /// Recursively parses given buffer
         bool deserialize(read_cursor& src) {
-            return deserialize_impl(src); }
+            PREFIX_STATS_DESERIALIZE(msg_t, src);
+            return deserialize_impl(src);
+        }
+    };
+    
+    /// Upcast to msg_t base: generated messages are declared as "struct X : msg_t<...> {}"
+    template <typename... T>
+    inline msg_t<T...> const& as_msg(msg_t<T...> const& msg) {
+        return msg; }
+    
+    /// msg_t<T...> underlying given message type (itself for plain msg_t)
+    template <typename Msg>
+    using msg_base_t = std::decay_t<decltype(as_msg(std::declval<Msg const&>()))>;
+    
+    
+    /// ------------------------! Layout report !------------------------ ///
+    
+    namespace details {
+        template <typename... T>
+        constexpr size_t sizes_sum() {
+            constexpr size_t sizes[] = { sizeof(T)..., 0 };
+            size_t sum = 0;
+            for(size_t i = 0; i < sizeof...(T); ++i)
+                sum += sizes[i];
+            return sum;
+        }
+    } // details
+    
+    /// Static sizeof/padding figures of msg_t storage, Msg may derive from msg_t
+    template <typename Msg>
+    struct layout_info : layout_info<msg_base_t<Msg>> {};
+    
+    template <typename... T>
+    struct layout_info<msg_t<T...>> {
+        enum : size_t {
+            size        = sizeof(msg_t<T...>),
+            fields_size = details::sizes_sum<T...>(),
+            padding     = size - fields_size,
+            cache_lines = (size + 63)/64
+        };
+        
+        /// Fields in storage order: offset, size, padding after field, tag, hotness
+        static std::string describe() {
+            struct entry {
+                size_t offset, size;
+                int tag;
+                bool hot;
+            };
+            
+            msg_t<T...> msg;
+            char const* base = reinterpret_cast<char const*>(&msg);
+            std::vector<entry> entries{ entry{
+                size_t(reinterpret_cast<char const*>(&msg.template at<T>()) - base),
+                sizeof(T), T::tag, hot_field<T>::value}... };
+            std::sort(entries.begin(), entries.end(), [](entry const& a, entry const& b) {
+                return a.offset < b.offset; });
+            
+            char line[128];
+            std::snprintf(line, sizeof(line), "size %zu (%zu cache lines), fields %zu, padding %zu\n",
+                size_t(size), size_t(cache_lines), size_t(fields_size), size_t(padding));
+            std::string res = line;
+            for(size_t i = 0; i < entries.size(); ++i) {
+                auto const& e = entries[i];
+                size_t end = i + 1 < entries.size() ? entries[i + 1].offset : size_t(size);
+                std::snprintf(line, sizeof(line), "  +%-5zu %5zu %4zu  tag %d%s\n",
+                    e.offset, e.size, end - e.offset - e.size, e.tag, e.hot ? " hot" : "");
+                res += line;
+            }
+            return res;
+        }
     };
     
     
@@ -250,9 +640,7 @@ namespace preFIX { namespace dict {
         template <typename T>
         bool serialize_trailer(write_cursor& dst, T& trailer) {
             auto base = dst.pointer() - dst.processed();
-            int sum = 0;
-            for(int i = 0; i < dst.processed(); ++i)
-                sum += int(base[i]);
+            int sum = sum_bytes(base, dst.processed());
             
             trailer.template set<CheckSum>(sum % 256);
             return trailer.serialize(dst);
@@ -269,9 +657,97 @@ namespace preFIX { namespace dict {
     
     /// ------------------------! Deserialization !------------------------ ///
     
+    /**
+     * Finds message boundary using BeginString, Length and CheckSum fields:
+     * "8=...<SOH>9=N<SOH>" + N bytes + "10=XXX<SOH>".
+     * @returns full message size, 0 if more data is needed, -1 if data is malformed
+     */
+    inline int frame_message(read_cursor const& src) {
+        char const* begin = src.pointer();
+        char const* end = begin + src.left();
+        
+        // "8=" ... SOH
+        if(src.left() < 2)
+            return 0;
+        if(begin[0] != '8' || begin[1] != '=')
+            return -1;
+        
+        char const* ptr = std::find(begin + 2, end, char(SOH));
+        if(ptr == end)
+            return 0;
+        
+        // "9=" digits SOH
+        if(end - ++ptr < 2)
+            return 0;
+        if(ptr[0] != '9' || ptr[1] != '=')
+            return -1;
+        
+        long length = 0;
+        char const* digits = ptr += 2;
+        for(; ptr != end && *ptr != char(SOH); ++ptr) {
+            unsigned digit = unsigned(*ptr - '0');
+            if(digit > 9 || length > std::numeric_limits<int>::max()/10)
+                return -1;
+            length = 10*length + digit;
+        }
+        if(ptr == end)
+            return 0;
+        if(ptr == digits)
+            return -1; // empty BodyLength
+        
+        // body + "10=XXX" SOH
+        long total = (ptr + 1 - begin) + length + 7;
+        if(total > std::numeric_limits<int>::max())
+            return -1;
+        if(total > src.left())
+            return 0;
+        
+        char const* trailer = begin + total - 7;
+        if(trailer[-1] != char(SOH) || std::memcmp(trailer, "10=", 3) != 0 || trailer[6] != char(SOH))
+            return -1;
+        
+        return int(total);
+    }
+    
+    /// Checks framing and CheckSum of exactly one message
+    inline bool validate_message(read_cursor const& src) {
+        if(frame_message(src) != src.left())
+            return false;
+        
+        char const* ptr = src.pointer();
+        char const* trailer = ptr + src.left() - 7;
+        
+        int sum = sum_bytes(ptr, trailer - ptr) % 256;
+        
+        unsigned bad = 0, value = 0;
+        for(int i = 3; i < 6; ++i) {
+            unsigned digit = unsigned(trailer[i] - '0');
+            bad |= (digit > 9);
+            value = 10*value + digit;
+        }
+        
+        return !bad && int(value) == sum;
+    }
     
 
 } // dict
+
+#ifdef PREFIX_INSTRUMENT
+namespace stats {
+    template <typename... T>
+    struct kind_of<dict::msg_t<T...>> {
+        static char const* value() { return "msg"; } };
+    
+    template <typename... T>
+    struct kind_of<dict::Group<T...>> {
+        static char const* value() { return "group"; } };
+    
+    template <typename L, typename U>
+    struct kind_of<dict::Data<L, U>> {
+        static char const* value() { return "data"; } };
+} // stats
+#endif
+
 } // preFIX
 
 /// Example of FIX-dictionary
@@ -285,6 +761,8 @@ namespace test_dict {
     using TargetCompID  = field_base<56,    String>;
     using MsgSeqNum     = field_base<34,    Int>;
     using PossDupFlag   = field_base<43,    Char>;
+    using SendingTime   = field_base<52,    UTCTimestamp<>>;
+    using OrigSendingTime = field_base<122, UTCTimestamp<>>;
     
     /// via "using"
     using Account       = field_base<1,     String>;
@@ -298,6 +776,19 @@ namespace test_dict {
     using PartyRole     = field_base<452,   Int>;
     using Price         = field_base<44,    Float>;
     using Side          = field_base<54,    Char>;
+    using Symbol        = field_base<55,    String>;
+    using TransactTime  = field_base<60,    UTCTimestamp<precision::us>>;
+    
+    using OrderID       = field_base<37,    String>;
+    using ExecID        = field_base<17,    String>;
+    using ExecType      = field_base<150,   Char>;
+    using OrdStatus     = field_base<39,    Char>;
+    using OrderQty      = field_base<38,    Float>;
+    using LastQty       = field_base<32,    Float>;
+    using LastPx        = field_base<31,    Float>;
+    using LeavesQty     = field_base<151,   Float>;
+    using CumQty        = field_base<14,    Float>;
+    using AvgPx         = field_base<6,     Float>;
     
     
     using NoPartyID = group_base<453,
@@ -313,7 +804,9 @@ namespace test_dict {
         SenderCompID,
         TargetCompID,
         MsgSeqNum,
-        PossDupFlag
+        PossDupFlag,
+        SendingTime,
+        OrigSendingTime
     >;
     
     using NewOrderSingle = msg_t<
@@ -328,6 +821,61 @@ namespace test_dict {
         CheckSum
     >;
     
+    using Logon = msg_t<
+        EncryptMethod,
+        HeartBtInt,
+        Password
+    >;
+    
+    using ExecutionReport = msg_t<
+        OrderID,
+        ClOrdID,
+        ExecID,
+        ExecType,
+        OrdStatus,
+        Account,
+        NoPartyID,
+        Symbol,
+        Side,
+        OrderQty,
+        Price,
+        LastQty,
+        LastPx,
+        LeavesQty,
+        CumQty,
+        AvgPx,
+        TransactTime
+    >;
+    
+    
+    using MDUpdateAction= field_base<279,   Char>;
+    using MDEntryType   = field_base<269,   Char>;
+    using MDEntryPx     = field_base<270,   Float>;
+    using MDEntrySize   = field_base<271,   Float>;
+    
+    using NoMDEntries = group_base<268,
+        MDUpdateAction,
+        MDEntryType,
+        Symbol,
+        MDEntryPx,
+        MDEntrySize
+    >;
+    
+    using NoMDEntriesSnapshot = group_base<268,
+        MDEntryType,
+        MDEntryPx,
+        MDEntrySize
+    >;
+    
+    using MarketDataIncrementalRefresh = msg_t<
+        NoMDEntries
+    >;
+    
+    using MarketDataSnapshotFullRefresh = msg_t<
+        Symbol,
+        NoMDEntriesSnapshot
+    >;
+    
     
     using NoOrders = group_base<999,
         ClOrdID,
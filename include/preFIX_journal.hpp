@@ -0,0 +1,588 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <preFIX.hpp>
+
+namespace preFIX {
+    
+    /**
+     * Persistent outbound messages storage (POSIX mmap). File layout:
+     * [header page][index: capacity x entry][segment 0][segment 1]...
+     * Index is addressed directly by MsgSeqNum => O(1) lookup.
+     * Segments are allocated and prefaulted ahead by prepare() (also called
+     * by flush()), so reserve() only switches to ready spare segment.
+     * If prepare() wasn't called since last roll, reserve() maps segment
+     * inline (counted by inline_rolls()) or fails if segments list would
+     * have to grow: it's grown only by open() and prepare().
+     * Usage:
+     *   auto wc = journal.reserve();
+     *   serialize_message(wc, header, msg, trailer);
+     *   journal.commit(seq, wc);
+     *   // send(wc.pointer() - wc.processed(), wc.processed())
+     *   ...
+     *   journal.flush();   // off the hot path, e.g. on timer
+     */
+    class journal {
+    public:
+        /// Index entry: global file offset and size of stored message
+        struct entry {
+            std::uint64_t offset;
+            std::uint32_t size;
+            std::uint32_t reserved;
+        };
+    
+    private:
+        enum : std::uint64_t {
+            magic_value = 0x4C4E524A58494650ULL, // "PFIXJRNL"
+            header_size = 4096
+        };
+        
+        struct file_header {
+            std::uint64_t magic;
+            std::uint64_t segment_size;
+            std::uint64_t capacity;
+        };
+        
+        int fd_ = -1;
+        size_t segment_size_ = 0;
+        size_t capacity_ = 0;
+        int max_message_ = 0;
+        
+        char*  meta_ = nullptr;         // header + index mapping
+        size_t meta_size_ = 0;
+        entry* index_ = nullptr;
+        
+        std::vector<char*> segments_;   // all mapped segments, last one is spare
+        size_t active_ = 0;             // segment currently being appended
+        size_t tail_ = 0;               // append offset inside active segment
+        int last_seq_ = -1;             // highest committed MsgSeqNum
+        size_t inline_rolls_ = 0;       // spare segments mapped by reserve()
+        
+        size_t segments_base() const {
+            return meta_size_; }
+        
+        /// Extends file by one allocated (not sparse) segment and maps it prefaulted
+        bool map_segment() {
+            off_t off = segments_base() + segments_.size()*segment_size_;
+            if(::posix_fallocate(fd_, off, segment_size_) != 0)
+                return false;
+            
+            int flags = MAP_SHARED;
+        #ifdef MAP_POPULATE
+            flags |= MAP_POPULATE;
+        #endif
+            void* ptr = ::mmap(nullptr, segment_size_,
+                PROT_READ | PROT_WRITE, flags, fd_, off);
+            if(ptr == MAP_FAILED)
+                return false;
+            
+            segments_.push_back(static_cast<char*>(ptr));
+            return true;
+        }
+        
+        /// Switches to spare segment (mapped inline only if prepare() wasn't called since last roll)
+        bool roll() {
+            if(active_ + 1 >= segments_.size()) {
+                if(segments_.size() == segments_.capacity() || !map_segment())
+                    return false;
+                ++inline_rolls_;
+            }
+            ++active_;
+            tail_ = 0;
+            return true;
+        }
+        
+        /// Restores append position and last MsgSeqNum from index (after reopening or reset)
+        void recover() {
+            active_ = tail_ = 0;
+            last_seq_ = -1;
+            
+            std::uint64_t end = 0;
+            for(size_t i = 0; i < capacity_; ++i)
+                if(index_[i].size != 0) {
+                    end = std::max(end, index_[i].offset + index_[i].size);
+                    last_seq_ = int(i);
+                }
+            
+            if(end != 0) {
+                end -= segments_base();
+                active_ = end/segment_size_;
+                tail_   = end%segment_size_;
+            }
+        }
+    
+    public:
+        journal() = default;
+        journal(journal const&) = delete;
+        journal& operator=(journal const&) = delete;
+        
+        ~journal() {
+            close(); }
+        
+        /**
+         * Opens (or creates) journal file.
+         * @param segment_size - size of single preallocated segment
+         * @param capacity - max MsgSeqNum + 1
+         * @param max_message - reserve() guarantees at least this space
+         */
+        bool open(std::string const& path,
+            size_t segment_size = 16 << 20,
+            size_t capacity = 1 << 20,
+            int max_message = 64 << 10)
+        {
+            close();
+            
+            long page = ::sysconf(_SC_PAGESIZE);
+            segment_size = (segment_size + page - 1)/page*page;
+            
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if(fd_ < 0)
+                return false;
+            
+            struct stat st;
+            if(::fstat(fd_, &st) != 0)
+                return close(), false;
+            
+            bool fresh = (st.st_size == 0);
+            
+            // Existing journal dictates its own geometry
+            if(!fresh) {
+                file_header fh;
+                if(::pread(fd_, &fh, sizeof(fh), 0) != sizeof(fh) || fh.magic != magic_value)
+                    return close(), false;
+                segment_size = fh.segment_size;
+                capacity = fh.capacity;
+            }
+            if(max_message <= 0 || size_t(max_message) > segment_size)
+                return close(), false;
+            
+            segment_size_ = segment_size;
+            capacity_ = capacity;
+            max_message_ = max_message;
+            
+            meta_size_ = header_size + capacity_*sizeof(entry);
+            meta_size_ = (meta_size_ + page - 1)/page*page;
+            
+            if(fresh && ::ftruncate(fd_, meta_size_) != 0)
+                return close(), false;
+            
+            void* ptr = ::mmap(nullptr, meta_size_,
+                PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if(ptr == MAP_FAILED)
+                return close(), false;
+            
+            meta_  = static_cast<char*>(ptr);
+            index_ = reinterpret_cast<entry*>(meta_ + header_size);
+            
+            if(fresh) {
+                file_header fh = {magic_value, segment_size_, capacity_};
+                std::memcpy(meta_, &fh, sizeof(fh));
+            }
+            
+            size_t existing = fresh ? 0 : (st.st_size - std::min<size_t>(st.st_size, meta_size_))/segment_size_;
+            segments_.reserve(existing + 64);
+            for(size_t i = 0; i < existing; ++i)
+                if(!map_segment())
+                    return close(), false;
+            
+            recover();
+            
+            // Active segment + one spare
+            while(segments_.size() < active_ + 2)
+                if(!map_segment())
+                    return close(), false;
+            
+            return true;
+        }
+        
+        void close() {
+            for(auto seg : segments_)
+                ::munmap(seg, segment_size_);
+            segments_.clear();
+            
+            if(meta_)
+                ::munmap(meta_, meta_size_);
+            meta_ = nullptr;
+            index_ = nullptr;
+            
+            if(fd_ >= 0)
+                ::close(fd_);
+            fd_ = -1;
+            
+            active_ = tail_ = 0;
+            last_seq_ = -1;
+            inline_rolls_ = 0;
+        }
+        
+        bool is_open() const {
+            return fd_ >= 0; }
+        
+        size_t capacity() const {
+            return capacity_; }
+        
+        /// Highest committed MsgSeqNum, -1 if journal is empty
+        int last_seq() const {
+            return last_seq_; }
+        
+        /// Segments mapped on the hot path by reserve() (prepare() called too rarely)
+        size_t inline_rolls() const {
+            return inline_rolls_; }
+        
+        
+        /// ------------------------! Appending !------------------------ ///
+        
+        /**
+         * @returns cursor over free mapped space (at least max_message bytes),
+         * empty cursor on failure. Rolls to spare segment if needed.
+         */
+        write_cursor reserve() {
+            if(!is_open())
+                return write_cursor(nullptr, 0);
+            
+            if(segment_size_ - tail_ < size_t(max_message_) && !roll())
+                return write_cursor(nullptr, 0);
+            
+            return write_cursor(segments_[active_] + tail_, segment_size_ - tail_);
+        }
+        
+        /// Records data written through reserved cursor as message #seq
+        bool commit(int seq, write_cursor const& wc) {
+            if(seq < 0 || size_t(seq) >= capacity_ || wc.processed() <= 0)
+                return false;
+            
+            char* begin = wc.pointer() - wc.processed();
+            if(begin != segments_[active_] + tail_)
+                return false;
+            
+            entry& e = index_[seq];
+            e.offset = segments_base() + active_*segment_size_ + tail_;
+            e.size = wc.processed();
+            
+            tail_ += wc.processed();
+            last_seq_ = std::max(last_seq_, seq);
+            return true;
+        }
+        
+        /**
+         * Sequence reset: drops messages #next_seq and above (off the hot path).
+         * last_seq() becomes the highest remaining one, appending continues right
+         * after remaining messages => reset(1) reuses file from the first segment.
+         */
+        bool reset(int next_seq) {
+            if(!is_open() || next_seq < 0)
+                return false;
+            
+            if(size_t(next_seq) < capacity_)
+                std::memset(index_ + next_seq, 0, (capacity_ - next_seq)*sizeof(entry));
+            recover();
+            return true;
+        }
+        
+        /// Maps spare segment if active one is the last, grows segments list ahead (off the hot path)
+        bool prepare() {
+            if(!is_open())
+                return false;
+            if(segments_.capacity() - segments_.size() < 2)
+                segments_.reserve(2*segments_.capacity());
+            return active_ + 1 < segments_.size() || map_segment();
+        }
+        
+        /// Prepares spare segment, schedules write-back of dirty pages (off the hot path)
+        bool flush() {
+            bool res = prepare() && ::msync(meta_, meta_size_, MS_ASYNC) == 0;
+            for(auto seg : segments_)
+                res = res && ::msync(seg, segment_size_, MS_ASYNC) == 0;
+            return res;
+        }
+        
+        
+        /// ------------------------! Retrieval !------------------------ ///
+        
+        /// @returns cursor over stored message #seq (empty if absent)
+        read_cursor get(int seq) const {
+            if(seq < 0 || size_t(seq) >= capacity_ || index_[seq].size == 0)
+                return read_cursor(nullptr, 0);
+            
+            entry const& e = index_[seq];
+            auto off = e.offset - segments_base();
+            return read_cursor(segments_[off/segment_size_] + off%segment_size_, e.size);
+        }
+        
+        /// Mutable access to stored message (e.g. for rewrite_poss_dup)
+        write_cursor get_mutable(int seq) {
+            read_cursor rc = get(seq);
+            return write_cursor(const_cast<char*>(rc.pointer()), rc.left());
+        }
+        
+        /**
+         * Calls f(seq, read_cursor) for every stored message in [begin, end].
+         * end == 0 means "up to the last one" (ResendRequest semantics).
+         * @returns number of visited messages, gaps are skipped
+         */
+        template <typename F>
+        int range(int begin, int end, F&& f) const {
+            if(end == 0 || end > last_seq_)
+                end = last_seq_;
+            
+            int found = 0;
+            for(int seq = std::max(begin, 0); seq <= end; ++seq) {
+                read_cursor rc = get(seq);
+                if(rc.left() > 0) {
+                    f(seq, rc);
+                    ++found;
+                }
+            }
+            return found;
+        }
+    };
+    
+    
+    namespace details {
+        /// Standard header fields (FIX 4.4/5.0 StandardHeader, incl. NoHops group)
+        inline bool is_header_tag(int tag) {
+            switch(tag) {
+            case 8:   case 9:   case 35:  case 49:  case 56:  case 115: case 128:
+            case 90:  case 91:  case 50:  case 142: case 57:  case 143: case 116:
+            case 144: case 129: case 145: case 34:  case 43:  case 97:  case 52:
+            case 122: case 212: case 213: case 347: case 369: case 627: case 628:
+            case 629: case 630: case 1128: case 1129: case 1156:
+                return true;
+            default:
+                return false;
+            }
+        }
+        
+        /// Data tag of header length field (SecureDataLen => SecureData etc.), 0 if none
+        inline int data_tag_of(int length_tag) {
+            switch(length_tag) {
+            case 90:  return 91;    // SecureData
+            case 212: return 213;   // XmlData
+            default:  return 0;
+            }
+        }
+        
+        /// Field of raw message, offsets from message begin
+        struct raw_field {
+            int tag;
+            int begin;  // "TAG=..."
+            int value;  // value begin
+            int size;   // value size (SOH isn't included)
+        };
+        
+        /**
+         * Calls f(raw_field) for every standard header field inside [begin, end)
+         * in order, stops at the first non-header tag (body isn't parsed: its
+         * Data fields may contain SOH and "TAG=" in payload).
+         * Header Data values are skipped by their length field.
+         * @returns offset of body begin (end - begin if there is no body), -1 if data is malformed
+         */
+        template <typename F>
+        int for_each_header_field(char const* begin, char const* end, F&& f) {
+            int  data_tag  = 0;
+            long data_size = 0;
+            
+            char const* ptr = begin;
+            while(ptr != end) {
+                char const* field = ptr;
+                int tag = 0;
+                while(ptr != end && unsigned(*ptr - '0') <= 9 && ptr - field < 9)
+                    tag = 10*tag + (*ptr++ - '0');
+                if(ptr == end || *ptr != '=' || ptr == field)
+                    return -1;
+                if(!is_header_tag(tag))
+                    return int(field - begin);
+                
+                char const* value = ++ptr;
+                if(tag == data_tag) {
+                    if(end - value <= data_size || value[data_size] != char(SOH))
+                        return -1;
+                    ptr = value + data_size;
+                } else {
+                    ptr = std::find(value, end, char(SOH));
+                    if(ptr == end)
+                        return -1;
+                }
+                
+                data_tag = data_tag_of(tag);
+                if(data_tag) {
+                    data_size = 0;
+                    for(char const* d = value; d != ptr; ++d) {
+                        unsigned digit = unsigned(*d - '0');
+                        if(digit > 9 || data_size > std::numeric_limits<int>::max()/10)
+                            return -1;
+                        data_size = 10*data_size + digit;
+                    }
+                }
+                
+                f(raw_field{tag, int(field - begin), int(value - begin), int(ptr - value)});
+                ++ptr;
+            }
+            return int(end - begin);
+        }
+        
+        /// Offset of "10=" of final "<SOH>10=XXX<SOH>" field, -1 if absent
+        inline int checksum_field(char const* begin, int size) {
+            char const* trailer = begin + size - 7;
+            if(size < 8 || trailer[-1] != char(SOH) || std::memcmp(trailer, "10=", 3) != 0 || trailer[6] != char(SOH))
+                return -1;
+            return size - 7;
+        }
+    }
+    
+    /**
+     * Prepares stored message for resending, in place:
+     * 43=N -> 43=Y, 122 <- old 52, 52 <- sending_time (if given), 10 recalculated.
+     * Only standard header is parsed (body is left as is), CheckSum is the final field.
+     * Requires message to be encoded with reserved slots (opt-in):
+     * PossDupFlag present and OrigSendingTime of the same width as SendingTime.
+     * Reserving changes the first transmission too: it carries 43=N and
+     * 122=<SendingTime>, though 122 is defined for PossDup resends only,
+     * so reserve only if the counterparty accepts it.
+     * @returns false if slots are absent (use copy_poss_dup() then)
+     */
+    inline bool rewrite_poss_dup(write_cursor msg, char const* sending_time = nullptr) {
+        char* begin = msg.pointer();
+        int checksum = details::checksum_field(begin, msg.left());
+        if(checksum < 0)
+            return false;
+        
+        details::raw_field none = {0, 0, 0, -1};
+        details::raw_field poss_dup = none, sending = none, orig_sent = none;
+        int body_begin = details::for_each_header_field(begin, begin + checksum, [&](details::raw_field const& f) {
+            details::raw_field* slot = f.tag == 43 ? &poss_dup : f.tag == 52 ? &sending : f.tag == 122 ? &orig_sent : nullptr;
+            if(slot && slot->size < 0)
+                *slot = f;
+        });
+        
+        int width = sending.size;
+        if(body_begin < 0 || width < 0 || orig_sent.size != width || poss_dup.size != 1)
+            return false;
+        
+        if(sending_time && int(std::strlen(sending_time)) != width)
+            return false;
+        
+        begin[poss_dup.value] = 'Y';
+        std::memcpy(begin + orig_sent.value, begin + sending.value, width);
+        if(sending_time)
+            std::memcpy(begin + sending.value, sending_time, width);
+        
+        // "<SOH>10=" => checksum covers everything up to SOH inclusive
+        int sum = sum_bytes(begin, checksum) % 256;
+        
+        char* digits = begin + checksum + 3;
+        digits[0] = '0' + sum/100;
+        digits[1] = '0' + sum/10%10;
+        digits[2] = '0' + sum%10;
+        return true;
+    }
+    
+    /**
+     * Copies stored message to dst prepared for resending, header is re-encoded:
+     * 43=Y (inserted before 52 if absent), 122 <- old 52 (inserted after 52
+     * if absent), 52 <- sending_time (if given), 9 and 10 recalculated.
+     * Works for messages sent without reserved slots, dst is moved past copy.
+     * Body is copied verbatim.
+     * @returns false if message is malformed, has no SendingTime or dst is too small
+     */
+    inline bool copy_poss_dup(read_cursor msg, write_cursor& dst, char const* sending_time = nullptr) {
+        char const* begin = msg.pointer();
+        int checksum = details::checksum_field(begin, msg.left());
+        if(checksum < 0)
+            return false;
+        
+        details::raw_field none = {0, 0, 0, -1};
+        details::raw_field length = none, poss_dup = none, sending = none, orig_sent = none;
+        int fields = 0;
+        int body_begin = details::for_each_header_field(begin, begin + checksum, [&](details::raw_field const& f) {
+            details::raw_field* slot = f.tag == 43 ? &poss_dup : f.tag == 52 ? &sending : f.tag == 122 ? &orig_sent :
+                (f.tag == 9 && fields == 1) ? &length : nullptr;
+            if(slot && slot->size < 0)
+                *slot = f;
+            ++fields;
+        });
+        if(body_begin < 0 || length.size < 0 || sending.size < 0)
+            return false;
+        
+        int width = sending.size;
+        int new_width = sending_time ? int(std::strlen(sending_time)) : width;
+        
+        // BodyLength: after "9=N<SOH>" up to "10="
+        int header_rest = length.value + length.size + 1;
+        long body = checksum - header_rest;
+        body += (poss_dup.size < 0) ? 5 : 1 - poss_dup.size;                        // "43=Y<SOH>"
+        body += new_width - width;                                                  // "52=..."
+        body += (orig_sent.size < 0) ? 5 + width : width - orig_sent.size;          // "122=...<SOH>"
+        
+        // Width of original Length is kept (zero-padded, see dict::Length)
+        char body_digits[24];
+        int body_size = std::snprintf(body_digits, sizeof(body_digits), "%0*ld", length.size, body);
+        if(body_size < 0 || body_size >= int(sizeof(body_digits)))
+            return false;
+        
+        write_cursor out = dst;
+        char* out_begin = out.pointer();
+        bool fits = true;
+        auto put = [&](char const* src, int size) {
+            fits = fits && out.left() >= size;
+            if(fits) {
+                std::memcpy(out.pointer(), src, size);
+                out.step(size);
+            }
+        };
+        
+        put(begin, length.value);
+        put(body_digits, body_size);
+        put("\x01", 1);
+        
+        details::for_each_header_field(begin + header_rest, begin + body_begin, [&](details::raw_field f) {
+            char const* field = begin + header_rest + f.begin;
+            int field_size = (f.value - f.begin) + f.size + 1;
+            f.value += header_rest;
+            
+            if(f.value == sending.value) {
+                if(poss_dup.size < 0)
+                    put("43=Y\x01", 5);
+                put("52=", 3);
+                put(sending_time ? sending_time : begin + sending.value, new_width);
+                put("\x01", 1);
+                if(orig_sent.size < 0) {
+                    put("122=", 4);
+                    put(begin + sending.value, width);
+                    put("\x01", 1);
+                }
+            } else if(f.value == poss_dup.value) {
+                put("43=Y\x01", 5);
+            } else if(f.value == orig_sent.value) {
+                put("122=", 4);
+                put(begin + sending.value, width);
+                put("\x01", 1);
+            } else {
+                put(field, field_size);
+            }
+        });
+        put(begin + body_begin, checksum - body_begin);
+        
+        int sum = fits ? sum_bytes(out_begin, out.pointer() - out_begin) % 256 : 0;
+        
+        char trailer[8] = { '1', '0', '=', char('0' + sum/100), char('0' + sum/10%10), char('0' + sum%10), SOH };
+        put(trailer, 7);
+        if(!fits)
+            return false;
+        
+        dst = out;
+        return true;
+    }
+
+} // preFIX
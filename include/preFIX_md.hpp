@@ -0,0 +1,363 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include <preFIX.hpp>
+
+/// Market data: decoding of 35=W/X directly into price-level books
+namespace preFIX { namespace md {
+    
+    using price_type = Float_underlying;
+    using size_type  = Float_underlying;
+    
+    /// Aggregated price level
+    struct level {
+        price_type price;
+        size_type  size;
+    };
+    
+    /**
+     * One side of the book: fixed array of levels sorted from the best one.
+     * Depth is small => linear scan over contiguous levels is the fastest.
+     * Levels worse than Depth-th one are dropped.
+     */
+    template <size_t Depth>
+    class book_side {
+    private:
+        std::array<level, Depth> levels_;
+        int count_;
+        bool descending_;
+        
+        inline bool better(price_type a, price_type b) const {
+            return descending_ ? a > b : a < b; }
+        
+        /// Position of the first level which isn't better than price
+        inline int lower_bound(price_type price) const {
+            int i = 0;
+            while(i < count_ && better(levels_[i].price, price))
+                ++i;
+            return i;
+        }
+    
+    public:
+        explicit book_side(bool descending) : count_(0), descending_(descending) {}
+        
+        void clear() {
+            count_ = 0; }
+        
+        /// Inserts new level or updates size of existing one
+        void set(price_type price, size_type size) {
+            int i = lower_bound(price);
+            if(i < count_ && levels_[i].price == price) {
+                levels_[i].size = size;
+                return;
+            }
+            
+            if(i == int(Depth))
+                return; // too deep
+            
+            int last = count_ < int(Depth) ? count_ : int(Depth) - 1;
+            std::memmove(&levels_[i + 1], &levels_[i], (last - i)*sizeof(level));
+            levels_[i] = {price, size};
+            count_ = last + 1;
+        }
+        
+        /// Removes level, @returns false if it isn't presented
+        bool remove(price_type price) {
+            int i = lower_bound(price);
+            if(i == count_ || levels_[i].price != price)
+                return false;
+            
+            std::memmove(&levels_[i], &levels_[i + 1], (count_ - i - 1)*sizeof(level));
+            --count_;
+            return true;
+        }
+        
+        inline int size() const {
+            return count_; }
+        
+        inline bool empty() const {
+            return count_ == 0; }
+        
+        inline level const& operator[](int idx) const {
+            return levels_[idx]; }
+        
+        /// Best level, undefined if empty()
+        inline level const& best() const {
+            return levels_[0]; }
+    };
+    
+    template <size_t Depth = 16>
+    struct order_book {
+        book_side<Depth> bids;
+        book_side<Depth> asks;
+        
+        order_book() : bids(true), asks(false) {}
+        
+        void clear() {
+            bids.clear();
+            asks.clear();
+        }
+    };
+    
+    /// Books by Symbol, last used book is cached
+    template <size_t Depth = 16>
+    class book_set {
+    public:
+        using book_type = order_book<Depth>;
+    
+    private:
+        std::unordered_map<std::string, book_type> books_;
+        std::string last_symbol_;
+        book_type*  last_book_ = nullptr;
+    
+    public:
+        /// Creates book if necessary
+        book_type& get(char const* symbol, int size) {
+            if(last_book_ && int(last_symbol_.size()) == size &&
+               std::memcmp(last_symbol_.data(), symbol, size) == 0)
+                return *last_book_;
+            
+            last_symbol_.assign(symbol, size);
+            last_book_ = &books_[last_symbol_];
+            return *last_book_;
+        }
+        
+        book_type& operator[](std::string const& symbol) {
+            return get(symbol.data(), symbol.size()); }
+        
+        book_type const* find(std::string const& symbol) const {
+            auto it = books_.find(symbol);
+            return it != books_.end() ? &it->second : nullptr;
+        }
+        
+        size_t size() const {
+            return books_.size(); }
+    };
+    
+    
+    namespace details {
+        /// Parses "TAG=", @returns tag or -1
+        inline int parse_tag(char const*& ptr, char const* end) {
+            int tag = 0;
+            char const* begin = ptr;
+            while(ptr != end && unsigned(*ptr - '0') <= 9)
+                tag = 10*tag + (*ptr++ - '0');
+            if(ptr == end || *ptr != '=' || ptr == begin)
+                return -1;
+            ++ptr;
+            return tag;
+        }
+        
+        /// Parses non-negative count "NNN" (at most 9 digits => fits int)
+        inline bool parse_count(char const* ptr, char const* end, int& value) {
+            if(ptr == end || end - ptr > 9)
+                return false;
+            int count = 0;
+            for(; ptr != end; ++ptr) {
+                unsigned d = unsigned(*ptr - '0');
+                if(d > 9)
+                    return false;
+                count = 10*count + int(d);
+            }
+            value = count;
+            return true;
+        }
+        
+        /// Parses decimal "[-]III[.FFF]" without locale/allocation
+        inline bool parse_decimal(char const* ptr, char const* end, double& value) {
+            static const double pows10[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+                1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+            };
+            
+            bool neg = (ptr != end && *ptr == '-');
+            ptr += neg;
+            
+            unsigned long long mantissa = 0;
+            int digits = 0, frac = -1;
+            for(; ptr != end; ++ptr) {
+                unsigned d = unsigned(*ptr - '0');
+                if(d <= 9) {
+                    mantissa = 10*mantissa + d;
+                    ++digits;
+                    frac += (frac >= 0);
+                } else if(*ptr == '.' && frac < 0) {
+                    frac = 0;
+                } else {
+                    return false;
+                }
+            }
+            
+            if(digits == 0 || digits > 18)
+                return false;
+            
+            value = double(mantissa);
+            if(frac > 0)
+                value /= pows10[frac];
+            if(neg)
+                value = -value;
+            return true;
+        }
+    } // details
+    
+    
+    /**
+     * Applies MarketDataSnapshotFullRefresh (35=W) and
+     * MarketDataIncrementalRefresh (35=X) straight to books:
+     * NoMDEntries(268) entries are parsed field by field and applied
+     * one by one, no intermediate messages are created.
+     * Recognized entry fields: MDUpdateAction(279), MDEntryType(269),
+     * Symbol(55), MDEntryPx(270), MDEntrySize(271); others are skipped.
+     * Entries are applied as they are parsed => when decode() fails
+     * (malformed value or NoMDEntries, fewer/more entries than declared) entries
+     * before the error are already applied and affected books must be
+     * resynced (e.g. from a new snapshot).
+     */
+    template <size_t Depth = 16>
+    class md_decoder {
+    public:
+        using books_type = book_set<Depth>;
+        
+        enum : int {
+            tag_MsgType         = 35,
+            tag_Symbol          = 55,
+            tag_CheckSum        = 10,
+            tag_NoMDEntries     = 268,
+            tag_MDEntryType     = 269,
+            tag_MDEntryPx       = 270,
+            tag_MDEntrySize     = 271,
+            tag_MDUpdateAction  = 279
+        };
+    
+    private:
+        struct entry {
+            char action;
+            char type;
+            char const* symbol;
+            int symbol_size;
+            price_type price;
+            size_type size;
+        };
+        
+        books_type& books_;
+        size_t applied_ = 0;
+        
+        void apply(entry const& e, bool snapshot) {
+            if(e.symbol_size == 0 || (e.type != '0' && e.type != '1'))
+                return; // trades, stats etc.
+            
+            auto& book = books_.get(e.symbol, e.symbol_size);
+            auto& side = (e.type == '0') ? book.bids : book.asks;
+            
+            if(!snapshot && e.action == '2')
+                side.remove(e.price);
+            else
+                side.set(e.price, e.size);
+            
+            ++applied_;
+        }
+    
+    public:
+        explicit md_decoder(books_type& books) : books_(books) {}
+        
+        /// Number of entries applied to books so far
+        size_t applied() const {
+            return applied_; }
+        
+        /// Decodes whole message (header..trailer or body only with known type),
+        /// false => books may be partially updated, see above
+        bool decode(read_cursor& src, char msg_type = 0) {
+            char const* ptr = src.pointer();
+            char const* end = ptr + src.left();
+            
+            entry e = {'0', 0, nullptr, 0, 0, 0};
+            int delimiter = 0;      // first tag of group entry
+            int left = -1;          // entries to be read
+            bool pending = false;
+            bool snapshot = (msg_type == 'W');
+            
+            while(ptr != end) {
+                int tag = details::parse_tag(ptr, end);
+                char const* val = static_cast<char const*>(std::memchr(ptr, SOH, end - ptr));
+                if(tag < 0 || !val)
+                    return false;
+                
+                char const* vbeg = ptr;
+                int vsize = int(val - ptr);
+                ptr = val + 1;
+                
+                if(tag == tag_CheckSum)
+                    break;
+                
+                if(left < 0) {
+                    // Message level fields
+                    switch(tag) {
+                    case tag_MsgType:
+                        snapshot = (vsize == 1 && *vbeg == 'W');
+                        break;
+                    case tag_Symbol:
+                        e.symbol = vbeg;
+                        e.symbol_size = vsize;
+                        break;
+                    case tag_NoMDEntries:
+                        if(!details::parse_count(vbeg, val, left))
+                            return false;
+                        if(snapshot && e.symbol_size) {
+                            auto& book = books_.get(e.symbol, e.symbol_size);
+                            book.clear();
+                        }
+                        break;
+                    }
+                    continue;
+                }
+                
+                if(delimiter == 0)
+                    delimiter = tag;
+                
+                if(tag == delimiter) {
+                    if(pending)
+                        apply(e, snapshot);
+                    if(left-- == 0)
+                        return false; // more entries than declared
+                    pending = true;
+                    e.action = '0';
+                    e.type = 0;
+                    e.price = e.size = 0;
+                }
+                
+                switch(tag) {
+                case tag_MDUpdateAction:
+                    e.action = *vbeg;
+                    break;
+                case tag_MDEntryType:
+                    e.type = *vbeg;
+                    break;
+                case tag_Symbol:
+                    e.symbol = vbeg;
+                    e.symbol_size = vsize;
+                    break;
+                case tag_MDEntryPx:
+                    if(!details::parse_decimal(vbeg, val, e.price))
+                        return false;
+                    break;
+                case tag_MDEntrySize:
+                    if(!details::parse_decimal(vbeg, val, e.size))
+                        return false;
+                    break;
+                }
+            }
+            
+            if(pending)
+                apply(e, snapshot);
+            
+            src.step(int(ptr - src.pointer()));
+            return left <= 0;
+        }
+    };
+
+} // md
+} // preFIX
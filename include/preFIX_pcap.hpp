@@ -0,0 +1,794 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <preFIX.hpp>
+#include <preFIX_dict.hpp>
+
+/**
+ * Offline capture processing: pcap/pcapng reader, Ethernet/IPv4/IPv6/TCP
+ * decoding, per-direction TCP reassembly and FIX framing, plus binary
+ * corpus of framed messages for replay benchmarks.
+ * Usage:
+ *   pcap::mapped_file file;
+ *   pcap::reassembler tcp;
+ *   file.open("session.pcap") && pcap::extract(file.data(), file.size(), tcp,
+ *       [](pcap::record const& r) { ... r.frame ... });
+ */
+namespace preFIX { namespace pcap {
+    
+    /// Read-only mapping of whole file
+    class mapped_file {
+    private:
+        char const* data_ = nullptr;
+        size_t size_ = 0;
+    
+    public:
+        mapped_file() = default;
+        mapped_file(mapped_file const&) = delete;
+        mapped_file& operator=(mapped_file const&) = delete;
+        
+        ~mapped_file() {
+            close(); }
+        
+        bool open(std::string const& path) {
+            close();
+            
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0)
+                return false;
+            
+            struct stat st;
+            if(::fstat(fd, &st) != 0) {
+                ::close(fd);
+                return false;
+            }
+            
+            size_ = size_t(st.st_size);
+            if(size_ == 0) {
+                ::close(fd);
+                return true;
+            }
+            
+            void* ptr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if(ptr == MAP_FAILED) {
+                size_ = 0;
+                return false;
+            }
+            data_ = static_cast<char const*>(ptr);
+            return true;
+        }
+        
+        void close() {
+            if(data_)
+                ::munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+            size_ = 0;
+        }
+        
+        inline char const* data() const {
+            return data_; }
+        
+        inline size_t size() const {
+            return size_; }
+    };
+    
+    
+    /// ------------------------! Capture files !------------------------ ///
+    
+    enum linktype : int {
+        link_null       = 0,    // BSD loopback, host order family
+        link_ethernet   = 1,
+        link_raw        = 101,  // IPv4/IPv6 without link header
+        link_loop       = 108,  // as link_null, network order
+        link_linux_sll  = 113,
+        link_ipv4       = 228,
+        link_ipv6       = 229,
+        link_linux_sll2 = 276
+    };
+    
+    /// Captured packet, data points into capture image
+    struct packet {
+        std::uint64_t timestamp_ns;
+        int linktype;
+        char const* data;
+        std::uint32_t size;     // captured bytes
+    };
+    
+    /**
+     * Iterates packets of pcap (us/ns timestamps, both byte orders) or
+     * pcapng (SHB/IDB/EPB/SPB blocks, several interfaces and sections,
+     * if_tsresol) image held in memory.
+     */
+    class packet_reader {
+    private:
+        enum : std::uint32_t {
+            pcap_us     = 0xA1B2C3D4,
+            pcap_ns     = 0xA1B23C4D,
+            ng_shb      = 0x0A0D0D0A,
+            ng_idb      = 1,
+            ng_spb      = 3,
+            ng_epb      = 6,
+            ng_order    = 0x1A2B3C4D
+        };
+        
+        enum format_t { none, classic, ng };
+        
+        struct interface {
+            int linktype;
+            bool binary;            // resolution is 2^-exp s, not 10^-exp s
+            int exp;
+        };
+        
+        char const* ptr_ = nullptr;
+        char const* end_ = nullptr;
+        format_t format_ = none;
+        bool swap_ = false;
+        bool error_ = false;
+        
+        // classic
+        int linktype_ = 0;
+        std::uint64_t ns_per_unit_ = 1000;
+        
+        // pcapng
+        std::vector<interface> ifaces_;
+        
+        static std::uint32_t bswap(std::uint32_t v) {
+            return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24); }
+        
+        static std::uint16_t bswap(std::uint16_t v) {
+            return std::uint16_t((v >> 8) | (v << 8)); }
+        
+        template <typename U>
+        U load(char const* p) const {
+            U v;
+            std::memcpy(&v, p, sizeof(v));
+            return swap_ ? bswap(v) : v;
+        }
+        
+        bool fail() {
+            error_ = true;
+            ptr_ = end_;
+            return false;
+        }
+        
+        static std::uint64_t to_ns(interface const& i, std::uint64_t ts) {
+            if(i.binary) {
+                std::uint64_t sec = ts >> i.exp;
+                std::uint64_t frac = ts & ((std::uint64_t(1) << i.exp) - 1);
+                return sec*1000000000ULL + std::uint64_t(double(frac)*1e9/double(std::uint64_t(1) << i.exp));
+            }
+            if(i.exp <= 9) {
+                std::uint64_t mul = 1;
+                for(int e = i.exp; e < 9; ++e)
+                    mul *= 10;
+                return ts*mul;
+            }
+            std::uint64_t div = 1;
+            for(int e = 9; e < i.exp; ++e)
+                div *= 10;
+            return ts/div;
+        }
+        
+        /// Reads if_tsresol option of IDB (options start at `p`)
+        void idb_options(char const* p, char const* end, interface& i) const {
+            while(end - p >= 4) {
+                std::uint16_t code = load<std::uint16_t>(p);
+                std::uint16_t len  = load<std::uint16_t>(p + 2);
+                p += 4;
+                if(code == 0 || end - p < len)
+                    return;
+                if(code == 9 && len >= 1) {
+                    unsigned char res = static_cast<unsigned char>(*p);
+                    i.binary = (res & 0x80) != 0;
+                    i.exp = res & 0x7F;
+                    if((i.binary && i.exp > 63) || (!i.binary && i.exp > 19))
+                        i.exp = i.binary ? 63 : 19;
+                }
+                p += (len + 3) & ~3;
+            }
+        }
+        
+        bool next_classic(packet& p) {
+            if(end_ - ptr_ >= 16) {
+                std::uint32_t sec  = load<std::uint32_t>(ptr_);
+                std::uint32_t frac = load<std::uint32_t>(ptr_ + 4);
+                std::uint32_t incl = load<std::uint32_t>(ptr_ + 8);
+                if(std::uint64_t(end_ - ptr_ - 16) < incl)
+                    return fail();
+                
+                p.timestamp_ns = std::uint64_t(sec)*1000000000ULL + std::uint64_t(frac)*ns_per_unit_;
+                p.linktype = linktype_;
+                p.data = ptr_ + 16;
+                p.size = incl;
+                ptr_ += 16 + incl;
+                return true;
+            }
+            if(ptr_ != end_)
+                return fail();
+            return false;
+        }
+        
+        /// Section header: byte order is defined by its own magic
+        bool section(std::uint32_t length) {
+            ifaces_.clear();
+            if(length < 28 || length % 4 != 0 || std::uint64_t(end_ - ptr_) < length)
+                return fail();
+            ptr_ += length;
+            return true;
+        }
+        
+        bool next_ng(packet& p) {
+            while(end_ - ptr_ >= 12) {
+                std::uint32_t type = load<std::uint32_t>(ptr_);
+                if(type == ng_shb) {
+                    std::uint32_t order;
+                    std::memcpy(&order, ptr_ + 8, 4);
+                    if(order != ng_order && bswap(order) != ng_order)
+                        return fail();
+                    swap_ = (order != ng_order);
+                    if(!section(load<std::uint32_t>(ptr_ + 4)))
+                        return false;
+                    continue;
+                }
+                
+                std::uint32_t length = load<std::uint32_t>(ptr_ + 4);
+                if(length < 12 || length % 4 != 0 || std::uint64_t(end_ - ptr_) < length)
+                    return fail();
+                char const* body = ptr_ + 8;
+                char const* body_end = ptr_ + length - 4;
+                ptr_ += length;
+                
+                if(type == ng_idb) {
+                    if(body_end - body < 8)
+                        return fail();
+                    interface i{load<std::uint16_t>(body), false, 6};
+                    idb_options(body + 8, body_end, i);
+                    ifaces_.push_back(i);
+                } else if(type == ng_epb) {
+                    if(body_end - body < 20)
+                        return fail();
+                    std::uint32_t id = load<std::uint32_t>(body);
+                    std::uint64_t ts = (std::uint64_t(load<std::uint32_t>(body + 4)) << 32) | load<std::uint32_t>(body + 8);
+                    std::uint32_t caplen = load<std::uint32_t>(body + 12);
+                    if(id >= ifaces_.size() || std::uint64_t(body_end - body - 20) < caplen)
+                        return fail();
+                    
+                    p.timestamp_ns = to_ns(ifaces_[id], ts);
+                    p.linktype = ifaces_[id].linktype;
+                    p.data = body + 20;
+                    p.size = caplen;
+                    return true;
+                } else if(type == ng_spb) {
+                    if(body_end - body < 4 || ifaces_.empty())
+                        return fail();
+                    std::uint32_t len = load<std::uint32_t>(body);
+                    p.timestamp_ns = 0; // SPB has no timestamp
+                    p.linktype = ifaces_[0].linktype;
+                    p.data = body + 4;
+                    p.size = std::min<std::uint32_t>(len, std::uint32_t(body_end - body - 4));
+                    return true;
+                }
+                // other blocks (statistics, name resolution...) are skipped
+            }
+            if(ptr_ != end_)
+                return fail();
+            return false;
+        }
+    
+    public:
+        /// Detects format, @returns false if image isn't pcap/pcapng
+        bool open(char const* data, size_t size) {
+            ptr_ = data;
+            end_ = data + size;
+            format_ = none;
+            error_ = false;
+            ifaces_.clear();
+            
+            if(size < 24)
+                return fail();
+            
+            std::uint32_t magic;
+            std::memcpy(&magic, data, 4);
+            if(magic == ng_shb) {
+                format_ = ng;
+                return true;
+            }
+            
+            for(bool swapped : {false, true}) {
+                std::uint32_t m = swapped ? bswap(magic) : magic;
+                if(m == pcap_us || m == pcap_ns) {
+                    swap_ = swapped;
+                    format_ = classic;
+                    ns_per_unit_ = (m == pcap_ns) ? 1 : 1000;
+                    linktype_ = int(load<std::uint32_t>(data + 20) & 0xFFFF);
+                    ptr_ += 24;
+                    return true;
+                }
+            }
+            return fail();
+        }
+        
+        /// @returns false at the end of capture or on malformed data (see error())
+        bool next(packet& p) {
+            switch(format_) {
+                case classic:   return next_classic(p);
+                case ng:        return next_ng(p);
+                default:        return false;
+            }
+        }
+        
+        /// Capture is truncated or malformed
+        inline bool error() const {
+            return error_; }
+    };
+    
+    
+    /// ------------------------! Network layers !------------------------ ///
+    
+    /// One direction of TCP connection
+    struct flow_key {
+        std::uint8_t family;        // 4 or 6
+        std::uint8_t src[16];       // IPv4 uses first 4 bytes
+        std::uint8_t dst[16];
+        std::uint16_t sport;
+        std::uint16_t dport;
+        
+        bool operator<(flow_key const& other) const {
+            if(family != other.family)
+                return family < other.family;
+            if(sport != other.sport)
+                return sport < other.sport;
+            if(dport != other.dport)
+                return dport < other.dport;
+            int c = std::memcmp(src, other.src, sizeof(src));
+            return c != 0 ? c < 0 : std::memcmp(dst, other.dst, sizeof(dst)) < 0;
+        }
+        
+        /// "10.0.0.1:5001 -> 10.0.0.2:9878"
+        std::string to_string() const {
+            auto addr = [this](std::uint8_t const* a, std::uint16_t port) {
+                char buf[64];
+                if(family == 4) {
+                    std::snprintf(buf, sizeof(buf), "%u.%u.%u.%u:%u", a[0], a[1], a[2], a[3], unsigned(port));
+                } else {
+                    int n = 0;
+                    buf[n++] = '[';
+                    for(int i = 0; i < 16; i += 2)
+                        n += std::snprintf(buf + n, sizeof(buf) - n, i ? ":%x" : "%x", unsigned(a[i] << 8 | a[i + 1]));
+                    std::snprintf(buf + n, sizeof(buf) - n, "]:%u", unsigned(port));
+                }
+                return std::string(buf);
+            };
+            return addr(src, sport) + " -> " + addr(dst, dport);
+        }
+    };
+    
+    /// TCP segment decoded from packet
+    struct segment {
+        flow_key key;
+        std::uint32_t seq;
+        std::uint8_t flags;
+        char const* payload;
+        std::uint32_t size;
+    };
+    
+    enum tcp_flags : std::uint8_t { tcp_fin = 0x01, tcp_syn = 0x02, tcp_rst = 0x04 };
+    
+    namespace details {
+        inline std::uint16_t be16(char const* p) {
+            auto u = reinterpret_cast<unsigned char const*>(p);
+            return std::uint16_t(u[0] << 8 | u[1]);
+        }
+        
+        inline std::uint32_t be32(char const* p) {
+            return std::uint32_t(be16(p)) << 16 | be16(p + 2); }
+        
+        inline bool tcp(char const* p, char const* end, segment& s) {
+            if(end - p < 20)
+                return false;
+            int offset = (static_cast<unsigned char>(p[12]) >> 4)*4;
+            if(offset < 20 || end - p < offset)
+                return false;
+            
+            s.key.sport = be16(p);
+            s.key.dport = be16(p + 2);
+            s.seq = be32(p + 4);
+            s.flags = static_cast<std::uint8_t>(p[13]);
+            s.payload = p + offset;
+            s.size = std::uint32_t(end - p - offset);
+            return true;
+        }
+        
+        /// Fragments aren't reassembled (FIX sessions don't produce them)
+        inline bool ipv4(char const* p, char const* end, segment& s) {
+            if(end - p < 20)
+                return false;
+            int ihl = (p[0] & 0x0F)*4;
+            int total = be16(p + 2);
+            if(ihl < 20 || total < ihl || end - p < ihl)
+                return false;
+            if(p[9] != 6 || (be16(p + 6) & 0x3FFF) != 0)
+                return false;
+            
+            end = std::min(end, p + total); // drops Ethernet padding
+            s.key.family = 4;
+            std::memset(s.key.src, 0, sizeof(s.key.src));
+            std::memset(s.key.dst, 0, sizeof(s.key.dst));
+            std::memcpy(s.key.src, p + 12, 4);
+            std::memcpy(s.key.dst, p + 16, 4);
+            return tcp(p + ihl, end, s);
+        }
+        
+        inline bool ipv6(char const* p, char const* end, segment& s) {
+            if(end - p < 40)
+                return false;
+            end = std::min(end, p + 40 + be16(p + 4));
+            s.key.family = 6;
+            std::memcpy(s.key.src, p + 8, 16);
+            std::memcpy(s.key.dst, p + 24, 16);
+            
+            int next = static_cast<unsigned char>(p[6]);
+            p += 40;
+            // hop-by-hop, routing, destination options
+            while(next == 0 || next == 43 || next == 60) {
+                if(end - p < 8)
+                    return false;
+                int len = (static_cast<unsigned char>(p[1]) + 1)*8;
+                next = static_cast<unsigned char>(p[0]);
+                p += len;
+            }
+            return next == 6 && p <= end && tcp(p, end, s);
+        }
+        
+        inline bool ip(int ethertype, char const* p, char const* end, segment& s) {
+            switch(ethertype) {
+                case 0x0800:    return ipv4(p, end, s);
+                case 0x86DD:    return ipv6(p, end, s);
+                default:        return false;
+            }
+        }
+        
+        inline int ip_version(char const* p, char const* end) {
+            if(p == end)
+                return 0;
+            int v = static_cast<unsigned char>(*p) >> 4;
+            return v == 4 ? 0x0800 : v == 6 ? 0x86DD : 0;
+        }
+    } // details
+    
+    /// Decodes link/IP/TCP headers, @returns false if packet isn't TCP
+    inline bool decode_tcp(packet const& pkt, segment& s) {
+        char const* p = pkt.data;
+        char const* end = p + pkt.size;
+        
+        switch(pkt.linktype) {
+            case link_ethernet: {
+                if(end - p < 14)
+                    return false;
+                int type = details::be16(p + 12);
+                p += 14;
+                while(type == 0x8100 || type == 0x88A8) { // VLAN tags
+                    if(end - p < 4)
+                        return false;
+                    type = details::be16(p + 2);
+                    p += 4;
+                }
+                return details::ip(type, p, end, s);
+            }
+            case link_linux_sll:
+                return end - p >= 16 && details::ip(details::be16(p + 14), p + 16, end, s);
+            case link_linux_sll2:
+                return end - p >= 20 && details::ip(details::be16(p), p + 20, end, s);
+            case link_null:
+            case link_loop:
+                return end - p >= 4 && details::ip(details::ip_version(p + 4, end), p + 4, end, s);
+            case link_raw:
+            case link_ipv4:
+            case link_ipv6:
+                return details::ip(details::ip_version(p, end), p, end, s);
+            default:
+                return false;
+        }
+    }
+    
+    
+    /// ------------------------! Reassembly !------------------------ ///
+    
+    /// Framed FIX message, frame points into reassembler's buffer
+    struct record {
+        std::uint64_t timestamp_ns;     // packet completing the message
+        std::uint32_t session;
+        read_cursor frame;
+    };
+    
+    /**
+     * Reassembles TCP streams per direction (4-tuple) and frames FIX
+     * messages with dict::frame_message(). Every connection (SYN or first
+     * seen segment) becomes new session. Retransmitted bytes are trimmed,
+     * out-of-order segments wait until gap is filled (gap is skipped once
+     * pending data exceeds max_pending). Stream is resynchronized at next
+     * "8=FIX" after malformed data or skipped gap => capture may start
+     * in the middle of a message.
+     */
+    class reassembler {
+    public:
+        struct statistics {
+            size_t packets;     // TCP segments seen
+            size_t messages;
+            size_t gaps;        // skipped missing data
+            size_t dropped;     // bytes skipped to find next message
+        };
+    
+    private:
+        struct flow {
+            std::uint32_t session;
+            std::uint32_t next_seq;
+            std::uint64_t pos;                                  // stream offset of next_seq
+            std::vector<char> buffer;                           // unframed bytes
+            std::map<std::uint64_t, std::vector<char>> pending; // by stream offset
+            size_t pending_bytes;
+        };
+        
+        std::map<flow_key, flow> flows_;
+        std::vector<flow_key> sessions_;
+        size_t max_pending_;
+        statistics stats_;
+        
+        flow& start(flow_key const& key, std::uint32_t seq) {
+            flow& f = flows_[key];
+            f.session = std::uint32_t(sessions_.size());
+            f.next_seq = seq;
+            f.pos = 0;
+            f.buffer.clear();
+            f.pending.clear();
+            f.pending_bytes = 0;
+            sessions_.push_back(key);
+            return f;
+        }
+        
+        /// Appends bytes except first `skip` ones (already received)
+        void append(flow& f, char const* data, size_t size, size_t skip) {
+            if(skip >= size)
+                return;
+            f.buffer.insert(f.buffer.end(), data + skip, data + size);
+            f.next_seq += std::uint32_t(size - skip);
+            f.pos += size - skip;
+        }
+        
+        void drain(flow& f) {
+            while(!f.pending.empty()) {
+                auto it = f.pending.begin();
+                if(it->first > f.pos) {
+                    if(f.pending_bytes <= max_pending_)
+                        return;
+                    // gap: partial message before it is lost
+                    ++stats_.gaps;
+                    f.buffer.clear();
+                    f.next_seq += std::uint32_t(it->first - f.pos);
+                    f.pos = it->first;
+                }
+                append(f, it->second.data(), it->second.size(), size_t(f.pos - it->first));
+                f.pending_bytes -= it->second.size();
+                f.pending.erase(it);
+            }
+        }
+        
+        template <typename F>
+        void frame(flow& f, std::uint64_t timestamp_ns, F& callback) {
+            static char const begin_string[] = "8=FIX";
+            size_t head = 0;
+            while(head < f.buffer.size()) {
+                read_cursor src(f.buffer.data() + head, int(f.buffer.size() - head));
+                int size = dict::frame_message(src);
+                if(size == 0 && f.buffer.size() - head <= max_pending_)
+                    break;
+                if(size > 0) {
+                    ++stats_.messages;
+                    callback(record{timestamp_ns, f.session, read_cursor(src.pointer(), size)});
+                    head += size_t(size);
+                    continue;
+                }
+                
+                // malformed (or absurdly long) => next "8=FIX", its possible prefix is kept
+                size_t from = head + 1;
+                auto it = std::search(f.buffer.begin() + from, f.buffer.end(),
+                    begin_string, begin_string + sizeof(begin_string) - 1);
+                size_t next = it != f.buffer.end() ? size_t(it - f.buffer.begin()) :
+                    std::max(from, f.buffer.size() - std::min(f.buffer.size(), sizeof(begin_string) - 2));
+                stats_.dropped += next - head;
+                head = next;
+            }
+            f.buffer.erase(f.buffer.begin(), f.buffer.begin() + head);
+        }
+    
+    public:
+        explicit reassembler(size_t max_pending = 4 << 20) :
+            max_pending_(max_pending), stats_{0, 0, 0, 0} {}
+        
+        /// Feeds TCP segment, calls f(record const&) for every completed message
+        template <typename F>
+        void push(std::uint64_t timestamp_ns, segment const& s, F&& f) {
+            ++stats_.packets;
+            auto it = flows_.find(s.key);
+            
+            if(s.flags & tcp_syn) {
+                bool repeated = it != flows_.end() && it->second.pos == 0 && it->second.next_seq == s.seq + 1;
+                if(!repeated)
+                    start(s.key, s.seq + 1);
+                return;
+            }
+            
+            if(it == flows_.end()) {
+                if(s.size == 0 || (s.flags & tcp_rst))
+                    return;
+                start(s.key, s.seq);
+                it = flows_.find(s.key);
+            }
+            
+            flow& fl = it->second;
+            if(s.size > 0) {
+                std::int32_t diff = std::int32_t(s.seq - fl.next_seq);
+                if(diff > 0) {
+                    auto& slot = fl.pending[fl.pos + std::uint64_t(diff)];
+                    if(slot.size() < s.size) {
+                        fl.pending_bytes += s.size - slot.size();
+                        slot.assign(s.payload, s.payload + s.size);
+                    }
+                } else {
+                    append(fl, s.payload, s.size, size_t(-std::int64_t(diff)));
+                }
+                drain(fl);
+                frame(fl, timestamp_ns, f);
+            }
+            
+            if(s.flags & (tcp_fin | tcp_rst))
+                flows_.erase(it);
+        }
+        
+        /// Decodes packet and feeds it if it's TCP, @returns false otherwise
+        template <typename F>
+        bool push(packet const& p, F&& f) {
+            segment s;
+            if(!decode_tcp(p, s))
+                return false;
+            push(p.timestamp_ns, s, f);
+            return true;
+        }
+        
+        /// Connection direction of session id
+        inline flow_key const& session(std::uint32_t id) const {
+            return sessions_[id]; }
+        
+        inline size_t sessions() const {
+            return sessions_.size(); }
+        
+        inline statistics const& stats() const {
+            return stats_; }
+    };
+    
+    /**
+     * Reads whole capture image, calls f(record const&) for every message.
+     * @returns false if image isn't pcap/pcapng or it's malformed/truncated
+     * (messages before the damaged part are still delivered)
+     */
+    template <typename F>
+    bool extract(char const* data, size_t size, reassembler& tcp, F&& f) {
+        packet_reader reader;
+        if(!reader.open(data, size))
+            return false;
+        
+        packet p;
+        while(reader.next(p))
+            tcp.push(p, f);
+        return !reader.error();
+    }
+    
+    
+    /// ------------------------! Corpus !------------------------ ///
+    
+    /**
+     * Replay corpus: "PFIXCORP" u32 version u32 reserved, then records
+     * {u64 timestamp_ns, u32 session, u32 size, size bytes} (host order).
+     */
+    class corpus_writer {
+    private:
+        std::FILE* file_ = nullptr;
+    
+    public:
+        enum : std::uint32_t { version = 1 };
+        
+        corpus_writer() = default;
+        corpus_writer(corpus_writer const&) = delete;
+        corpus_writer& operator=(corpus_writer const&) = delete;
+        
+        ~corpus_writer() {
+            close(); }
+        
+        bool open(std::string const& path) {
+            close();
+            file_ = std::fopen(path.c_str(), "wb");
+            if(!file_)
+                return false;
+            
+            std::uint32_t header[4] = {0, 0, version, 0};
+            std::memcpy(header, "PFIXCORP", 8);
+            return std::fwrite(header, sizeof(header), 1, file_) == 1;
+        }
+        
+        bool write(record const& r) {
+            std::uint32_t meta[4] = {0, 0, r.session, std::uint32_t(r.frame.left())};
+            std::memcpy(meta, &r.timestamp_ns, 8);
+            return file_ &&
+                std::fwrite(meta, sizeof(meta), 1, file_) == 1 &&
+                std::fwrite(r.frame.pointer(), 1, r.frame.left(), file_) == size_t(r.frame.left());
+        }
+        
+        /// @returns false if some data wasn't written
+        bool close() {
+            bool res = true;
+            if(file_)
+                res = std::fclose(file_) == 0;
+            file_ = nullptr;
+            return res;
+        }
+    };
+    
+    /// Iterates records of corpus image (e.g. mapped_file)
+    class corpus_reader {
+    private:
+        char const* ptr_ = nullptr;
+        char const* end_ = nullptr;
+        bool error_ = false;
+    
+    public:
+        bool open(char const* data, size_t size) {
+            std::uint32_t version = 0;
+            if(size >= 16)
+                std::memcpy(&version, data + 8, 4);
+            
+            error_ = size < 16 || std::memcmp(data, "PFIXCORP", 8) != 0 || version != corpus_writer::version;
+            ptr_ = error_ ? nullptr : data + 16;
+            end_ = error_ ? nullptr : data + size;
+            return !error_;
+        }
+        
+        /// @returns false at the end or on truncated record (see error())
+        bool next(record& r) {
+            if(ptr_ == end_)
+                return false;
+            
+            std::uint32_t size = 0;
+            if(end_ - ptr_ >= 16)
+                std::memcpy(&size, ptr_ + 12, 4);
+            if(end_ - ptr_ < 16 || std::uint64_t(end_ - ptr_ - 16) < size || size > std::uint32_t(1u << 31) - 1) {
+                error_ = true;
+                ptr_ = end_;
+                return false;
+            }
+            
+            std::memcpy(&r.timestamp_ns, ptr_, 8);
+            std::memcpy(&r.session, ptr_ + 8, 4);
+            r.frame = read_cursor(ptr_ + 16, int(size));
+            ptr_ += 16 + size;
+            return true;
+        }
+        
+        inline bool error() const {
+            return error_; }
+    };
+
+} // pcap
+} // preFIX
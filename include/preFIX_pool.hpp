@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <preFIX.hpp>
+
+namespace preFIX {
+    
+    /**
+     * Fixed-size message buffers shared by encode/decode threads. Blocks are
+     * cache-line aligned slices of one mapping (optionally MAP_HUGETLB) and
+     * are never freed while pool lives => acquire/release don't allocate.
+     * Free blocks sit in lock-free stack (Treiber, ABA tag in head), every
+     * thread keeps small cache of them. Handle may be released by any thread.
+     * Blocks cached by one thread aren't visible to others until the cache
+     * overflows, flush_cache() is called or the thread exits.
+     * Usage:
+     *   buffer_pool pool(1024, 4096);
+     *   auto buf = pool.acquire();
+     *   auto wc = buf.writer();
+     *   serialize_message(wc, header, msg, trailer);
+     *   buf.resize(wc.processed());
+     *   queue.push(std::move(buf));    // another thread: buf.reader()
+     */
+    class buffer_pool {
+    public:
+        enum : size_t { cache_line = 64 };
+        
+        struct options {
+            bool hugepages = false;     // MAP_HUGETLB, falls back to transparent huge pages
+            bool prefault = true;       // touch pages now (first touch => memory of caller's NUMA node)
+            int cache_size = 32;        // blocks cached per thread (keep well below block count), 0 => shared stack only
+        };
+        
+        /// Owning handle of one block, movable between threads
+        class buffer {
+        private:
+            friend class buffer_pool;
+            
+            buffer_pool* pool_ = nullptr;
+            char* data_ = nullptr;
+            std::uint32_t index_ = 0;
+            int size_ = 0;
+            
+            buffer(buffer_pool* pool, std::uint32_t index) :
+                pool_(pool), data_(pool->block(index)), index_(index) {}
+        
+        public:
+            buffer() = default;
+            buffer(buffer const&) = delete;
+            buffer& operator=(buffer const&) = delete;
+            
+            buffer(buffer&& other) noexcept :
+                pool_(other.pool_), data_(other.data_), index_(other.index_), size_(other.size_) {
+                other.pool_ = nullptr;
+                other.data_ = nullptr;
+            }
+            
+            buffer& operator=(buffer&& other) noexcept {
+                if(this != &other) {
+                    reset();
+                    pool_ = other.pool_;
+                    data_ = other.data_;
+                    index_ = other.index_;
+                    size_ = other.size_;
+                    other.pool_ = nullptr;
+                    other.data_ = nullptr;
+                }
+                return *this;
+            }
+            
+            ~buffer() {
+                reset(); }
+            
+            /// Returns block to pool
+            void reset() {
+                if(pool_)
+                    pool_->release(index_);
+                pool_ = nullptr;
+                data_ = nullptr;
+                size_ = 0;
+            }
+            
+            explicit operator bool() const {
+                return data_ != nullptr; }
+            
+            inline char* data() const {
+                return data_; }
+            
+            inline int capacity() const {
+                return pool_ ? int(pool_->block_size()) : 0; }
+            
+            /// Bytes of payload (set by writer's owner)
+            inline int size() const {
+                return size_; }
+            
+            void resize(int size) {
+                size_ = size; }
+            
+            /// Cursor over whole block
+            write_cursor writer() const {
+                return write_cursor(data_, capacity()); }
+            
+            /// Cursor over size() bytes
+            read_cursor reader() const {
+                return read_cursor(data_, size_); }
+        };
+    
+    private:
+        enum : std::uint32_t { max_cache = 256, cache_slots = 4 };
+        enum : std::uint64_t { index_mask = 0xFFFFFFFFULL };
+        
+        /// Per-thread blocks of one pool
+        struct cache_slot {
+            std::uint64_t pool_id;
+            buffer_pool* pool;
+            std::uint32_t count;
+            std::uint32_t blocks[max_cache];
+        };
+        
+        /// Thread's caches, returned to live pools on thread exit
+        struct thread_cache {
+            cache_slot slots[cache_slots] = {};
+            std::uint64_t scanned = 0;  // destroyed() seen by last reclaim
+            
+            ~thread_cache() {
+                std::lock_guard<std::mutex> lock(registry_mutex());
+                for(auto& slot : slots)
+                    if(slot.pool_id && registry().count(slot.pool_id))
+                        slot.pool->push(slot.blocks, slot.count);
+            }
+        };
+        
+        char* region_ = nullptr;
+        size_t mapped_ = 0;
+        size_t block_size_ = 0;
+        std::uint32_t count_ = 0;
+        std::uint32_t cache_size_ = 0;
+        bool hugepages_ = false;
+        std::uint64_t id_ = 0;
+        std::unique_ptr<std::atomic<std::uint32_t>[]> next_;  // free stack links (index + 1)
+        
+        alignas(cache_line) std::atomic<std::uint64_t> head_{0};   // tag << 32 | (index + 1)
+        alignas(cache_line) std::atomic<std::int64_t> shared_free_{0};
+        
+        static std::mutex& registry_mutex() {
+            static std::mutex value;
+            return value;
+        }
+        
+        /// Ids of live pools (pool address may be reused)
+        static std::set<std::uint64_t>& registry() {
+            static std::set<std::uint64_t> value;
+            return value;
+        }
+        
+        /// Number of destroyed pools
+        static std::atomic<std::uint64_t>& destroyed() {
+            static std::atomic<std::uint64_t> value{0};
+            return value;
+        }
+        
+        static thread_cache& local() {
+            static thread_local thread_cache value;
+            return value;
+        }
+        
+        inline char* block(std::uint32_t index) const {
+            return region_ + index*block_size_; }
+        
+        /// Slot of this pool in calling thread's cache, nullptr if all are taken
+        cache_slot* slot() {
+            if(cache_size_ == 0)
+                return nullptr;
+            
+            auto& cache = local();
+            auto& slots = cache.slots;
+            for(auto& s : slots)
+                if(s.pool_id == id_)
+                    return &s;
+            for(auto& s : slots)
+                if(s.pool_id == 0)
+                    return &(s = cache_slot{id_, this, 0, {}});
+            
+            // Slots of destroyed pools are reclaimed (registry is locked only after some pool died)
+            std::uint64_t seen = destroyed().load(std::memory_order_relaxed);
+            if(seen == cache.scanned)
+                return nullptr;
+            cache.scanned = seen;
+            cache_slot* free = nullptr;
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            for(auto& s : slots)
+                if(!registry().count(s.pool_id)) {
+                    s.pool_id = 0;
+                    free = free ? free : &s;
+                }
+            return free ? &(*free = cache_slot{id_, this, 0, {}}) : nullptr;
+        }
+        
+        /// Links `count` blocks and pushes them with one CAS
+        void push(std::uint32_t const* blocks, std::uint32_t count) {
+            if(count == 0)
+                return;
+            for(std::uint32_t i = 0; i + 1 < count; ++i)
+                next_[blocks[i]].store(blocks[i + 1] + 1, std::memory_order_relaxed);
+            
+            std::uint64_t old = head_.load(std::memory_order_relaxed);
+            std::uint64_t top;
+            do {
+                next_[blocks[count - 1]].store(std::uint32_t(old & index_mask), std::memory_order_relaxed);
+                top = ((old >> 32) + 1) << 32 | (blocks[0] + 1);
+            } while(!head_.compare_exchange_weak(old, top, std::memory_order_release, std::memory_order_relaxed));
+            shared_free_.fetch_add(count, std::memory_order_relaxed);
+        }
+        
+        /// Pops up to max blocks, @returns number of popped ones
+        std::uint32_t pop(std::uint32_t* blocks, std::uint32_t max) {
+            std::uint32_t n = 0;
+            std::uint64_t old = head_.load(std::memory_order_acquire);
+            while(n < max) {
+                std::uint32_t top = std::uint32_t(old & index_mask);
+                if(top == 0)
+                    break;
+                std::uint64_t next = ((old >> 32) + 1) << 32 | next_[top - 1].load(std::memory_order_relaxed);
+                if(head_.compare_exchange_weak(old, next, std::memory_order_acquire, std::memory_order_acquire))
+                    blocks[n++] = top - 1;
+            }
+            shared_free_.fetch_sub(n, std::memory_order_relaxed);
+            return n;
+        }
+        
+        void release(std::uint32_t index) {
+            cache_slot* s = slot();
+            if(!s) {
+                push(&index, 1);
+                return;
+            }
+            if(s->count >= cache_size_) {
+                // Older half goes back => other threads can take it
+                std::uint32_t half = std::max<std::uint32_t>(cache_size_/2, 1);
+                push(s->blocks, half);
+                std::copy(s->blocks + half, s->blocks + s->count, s->blocks);
+                s->count -= half;
+            }
+            s->blocks[s->count++] = index;
+        }
+        
+        bool map(size_t size, int flags) {
+            void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+            if(ptr == MAP_FAILED)
+                return false;
+            region_ = static_cast<char*>(ptr);
+            mapped_ = size;
+            return true;
+        }
+    
+    public:
+        buffer_pool(size_t block_size, std::uint32_t block_count) :
+            buffer_pool(block_size, block_count, options()) {}
+        
+        /// block_size is rounded up to cache line, is_open() is false if mapping fails
+        buffer_pool(size_t block_size, std::uint32_t block_count, options const& opt) {
+            static std::atomic<std::uint64_t> last_id{0};
+            if(block_count == 0 || block_count == std::uint32_t(-1))
+                return;
+            
+            block_size_ = (std::max<size_t>(block_size, 1) + cache_line - 1)/cache_line*cache_line;
+            size_t size = block_size_*block_count;
+        
+        #ifdef MAP_HUGETLB
+            enum : size_t { huge_page = 2 << 20 };
+            if(opt.hugepages)
+                hugepages_ = map((size + huge_page - 1)/huge_page*huge_page, MAP_HUGETLB | (opt.prefault ? MAP_POPULATE : 0));
+        #endif
+            if(!hugepages_) {
+                size_t page = size_t(::sysconf(_SC_PAGESIZE));
+                if(!map((size + page - 1)/page*page, 0))
+                    return;
+            #ifdef MADV_HUGEPAGE
+                if(opt.hugepages)
+                    ::madvise(region_, mapped_, MADV_HUGEPAGE);
+            #endif
+                if(opt.prefault)
+                    for(size_t off = 0; off < mapped_; off += page)
+                        region_[off] = 0;
+            }
+            
+            count_ = block_count;
+            cache_size_ = std::uint32_t(std::min<int>(std::max(opt.cache_size, 0), max_cache));
+            next_.reset(new std::atomic<std::uint32_t>[count_]);
+            
+            std::unique_ptr<std::uint32_t[]> all(new std::uint32_t[count_]);
+            for(std::uint32_t i = 0; i < count_; ++i)
+                all[i] = i;
+            push(all.get(), count_);
+            
+            id_ = ++last_id;
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            registry().insert(id_);
+        }
+        
+        buffer_pool(buffer_pool const&) = delete;
+        buffer_pool& operator=(buffer_pool const&) = delete;
+        
+        /// All buffers must be released before
+        ~buffer_pool() {
+            if(id_) {
+                std::lock_guard<std::mutex> lock(registry_mutex());
+                registry().erase(id_);
+                destroyed().fetch_add(1, std::memory_order_relaxed);
+            }
+            for(auto& s : local().slots)
+                if(s.pool_id == id_)
+                    s.pool_id = 0;
+            if(region_)
+                ::munmap(region_, mapped_);
+        }
+        
+        /// Takes block (thread cache first), empty handle if pool is exhausted
+        buffer acquire() {
+            cache_slot* s = slot();
+            if(!s) {
+                std::uint32_t index;
+                return pop(&index, 1) ? buffer(this, index) : buffer();
+            }
+            if(s->count == 0)
+                s->count = pop(s->blocks, std::max<std::uint32_t>(cache_size_/2, 1));
+            return s->count ? buffer(this, s->blocks[--s->count]) : buffer();
+        }
+        
+        inline bool is_open() const {
+            return region_ != nullptr; }
+        
+        inline size_t block_size() const {
+            return block_size_; }
+        
+        inline std::uint32_t capacity() const {
+            return count_; }
+        
+        /// Blocks in shared stack (thread caches aren't counted), approximate under concurrent use
+        inline std::uint32_t available() const {
+            std::int64_t n = shared_free_.load(std::memory_order_relaxed);
+            return n > 0 ? std::uint32_t(n) : 0;
+        }
+        
+        /// Blocks in calling thread's cache
+        std::uint32_t cached() {
+            cache_slot* s = slot();
+            return s ? s->count : 0;
+        }
+        
+        /// Returns calling thread's cached blocks to shared stack
+        void flush_cache() {
+            if(cache_slot* s = slot()) {
+                push(s->blocks, s->count);
+                s->count = 0;
+            }
+        }
+        
+        /// Backed by MAP_HUGETLB pages
+        inline bool hugepages() const {
+            return hugepages_; }
+    };
+
+} // preFIX
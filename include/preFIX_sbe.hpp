@@ -0,0 +1,361 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include <preFIX.hpp>
+#include <preFIX_dict.hpp>
+
+/**
+ * Binary codec over the same msg_t dictionaries, SBE-style layout
+ * (little-endian, no per-field tags):
+ *   block:   fixed-size fields in declaration order
+ *            (int/time => int64, float => double, char => 1 byte),
+ *            null values are encoded as is
+ *   groups:  in declaration order, {u16 blockLength, u16 numInGroup}
+ *            followed by entries (block, groups, var-data)
+ *   vardata: strings and Data in declaration order, {u16 length} + bytes
+ * Framed message (serialize_binary_message):
+ *   Simple Open Framing Header {u32 BE length, u16 BE 0xEB50}, header, body.
+ * Decoding overwrites every field => no need to clear reused messages.
+ */
+namespace preFIX { namespace sbe {
+    
+    enum : std::uint16_t { sbe_le_encoding = 0xEB50 };
+    enum : int { framing_header_size = 6 };
+    
+    namespace details {
+        struct as_fixed {};
+        struct as_var {};
+        struct as_group {};
+        
+        template <int tag, typename... G>
+        std::true_type group_test(dict::field_base<tag, dict::Group<G...>> const*);
+        std::false_type group_test(...);
+        
+        template <typename V, bool group = decltype(group_test(static_cast<V const*>(nullptr)))::value>
+        struct kind_of {
+            using type = as_group; };
+        
+        template <typename V>
+        struct kind_of<V, false> {
+            using underlying = typename V::type::underlying_type;
+            static_assert(std::is_arithmetic<underlying>::value || std::is_same<underlying, std::string>::value ||
+                std::is_same<underlying, dict::data_view>::value, "field type has no binary encoding");
+            using type = typename std::conditional<std::is_arithmetic<underlying>::value, as_fixed, as_var>::type;
+        };
+        
+        /// Wire type of fixed field: char => 1 byte, integrals => int64, floating => double
+        template <typename U>
+        using wire_type = typename std::conditional<std::is_same<U, char>::value, char,
+            typename std::conditional<std::is_integral<U>::value, std::int64_t, double>::type>::type;
+        
+        template <typename V>
+        constexpr size_t fixed_size(as_fixed) {
+            return sizeof(wire_type<typename V::type::underlying_type>); }
+        
+        template <typename V, typename K>
+        constexpr size_t fixed_size(K) {
+            return 0; }
+        
+        template <typename... T>
+        constexpr size_t sum_fixed_sizes() {
+            constexpr size_t sizes[] = { fixed_size<T>(typename kind_of<T>::type{})..., 0 };
+            size_t sum = 0;
+            for(size_t i = 0; i < sizeof...(T); ++i)
+                sum += sizes[i];
+            return sum;
+        }
+        
+        /// Root/entry block size of message type, Msg may derive from msg_t
+        template <typename Msg>
+        struct block_length : block_length<dict::msg_base_t<Msg>> {};
+        
+        template <typename... T>
+        struct block_length<dict::msg_t<T...>> : std::integral_constant<size_t, sum_fixed_sizes<T...>()> {};
+        
+        
+        /// ------------------------! Little-endian primitives !------------------------ ///
+        
+        template <typename W>
+        inline void store(char* dst, W value) {
+        #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            char tmp[sizeof(W)];
+            std::memcpy(tmp, &value, sizeof(W));
+            for(size_t i = 0; i < sizeof(W); ++i)
+                dst[i] = tmp[sizeof(W) - 1 - i];
+        #else
+            std::memcpy(dst, &value, sizeof(W));
+        #endif
+        }
+        
+        template <typename W>
+        inline W load(char const* src) {
+            W value;
+        #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            char tmp[sizeof(W)];
+            for(size_t i = 0; i < sizeof(W); ++i)
+                tmp[i] = src[sizeof(W) - 1 - i];
+            std::memcpy(&value, tmp, sizeof(W));
+        #else
+            std::memcpy(&value, src, sizeof(W));
+        #endif
+            return value;
+        }
+        
+        template <typename W>
+        inline bool put(write_cursor& dst, W value) {
+            if(dst.left() < int(sizeof(W)))
+                return false;
+            store(dst.pointer(), value);
+            dst.step(sizeof(W));
+            return true;
+        }
+        
+        template <typename W>
+        inline bool get(read_cursor& src, W& value) {
+            if(src.left() < int(sizeof(W)))
+                return false;
+            value = load<W>(src.pointer());
+            src.step(sizeof(W));
+            return true;
+        }
+        
+        
+        /// ------------------------! Encoding !------------------------ ///
+        
+        template <typename Msg>
+        bool encode(write_cursor& dst, Msg const& msg);
+        
+        template <typename Msg>
+        bool decode(read_cursor& src, Msg& msg, size_t block);
+        
+        /// Every pass is called for every field, fields of other kinds are skipped
+        struct fixed_pass {
+            template <typename V>
+            static bool encode(write_cursor& dst, V const& field, as_fixed) {
+                using W = wire_type<typename V::type::underlying_type>;
+                return put(dst, W(field.value));
+            }
+            
+            template <typename V>
+            static bool decode(read_cursor& src, V& field, as_fixed) {
+                using U = typename V::type::underlying_type;
+                field.value = U(load<wire_type<U>>(src.pointer()));
+                src.step(sizeof(wire_type<U>));
+                return true;
+            }
+        };
+        
+        struct group_pass {
+            template <typename V>
+            static bool encode(write_cursor& dst, V const& field, as_group) {
+                using entry_type = typename V::type::group_element_type;
+                if(field.value.size() > std::numeric_limits<std::uint16_t>::max())
+                    return false;
+                bool res = put(dst, std::uint16_t(block_length<entry_type>::value)) &&
+                           put(dst, std::uint16_t(field.value.size()));
+                for(auto const& entry : field.value)
+                    res = res && details::encode(dst, entry);
+                return res;
+            }
+            
+            /// Larger blockLength (newer schema) is accepted, extra bytes are skipped
+            template <typename V>
+            static bool decode(read_cursor& src, V& field, as_group) {
+                using entry_type = typename V::type::group_element_type;
+                std::uint16_t block = 0, count = 0;
+                if(!get(src, block) || !get(src, count) || block < block_length<entry_type>::value)
+                    return false;
+                field.resize(count);
+                for(auto& entry : field.value)
+                    if(!details::decode(src, entry, block))
+                        return false;
+                return true;
+            }
+        };
+        
+        struct var_pass {
+            template <typename V>
+            static bool encode(write_cursor& dst, V const& field, as_var) {
+                auto const& str = field.value;
+                if(str.size() > std::numeric_limits<std::uint16_t>::max() ||
+                   dst.left() < int(sizeof(std::uint16_t) + str.size()))
+                    return false;
+                put(dst, std::uint16_t(str.size()));
+                std::memcpy(dst.pointer(), str.data(), str.size());
+                dst.step(int(str.size()));
+                return true;
+            }
+            
+            template <typename V>
+            static bool decode(read_cursor& src, V& field, as_var) {
+                std::uint16_t size = 0;
+                if(!get(src, size) || src.left() < size)
+                    return false;
+                field.value.assign(src.pointer(), size);
+                src.step(size);
+                return true;
+            }
+        };
+        
+        template <typename Pass>
+        struct run_pass : Pass {
+            using Pass::encode;
+            using Pass::decode;
+            
+            template <typename V, typename K>
+            static bool encode(write_cursor&, V const&, K) {
+                return true; }
+            
+            template <typename V, typename K>
+            static bool decode(read_cursor&, V&, K) {
+                return true; }
+        };
+        
+        template <typename Pass, typename Msg>
+        bool encode_pass(write_cursor& dst, Msg const& msg) {
+            bool res = true;
+            msg.for_each([&](auto const& field) {
+                using V = std::decay_t<decltype(field)>;
+                res = res && run_pass<Pass>::encode(dst, field, typename kind_of<V>::type{});
+            });
+            return res;
+        }
+        
+        template <typename Pass, typename Msg>
+        bool decode_pass(read_cursor& src, Msg& msg) {
+            bool res = true;
+            msg.for_each([&](auto& field) {
+                using V = std::decay_t<decltype(field)>;
+                res = res && run_pass<Pass>::decode(src, field, typename kind_of<V>::type{});
+            });
+            return res;
+        }
+        
+        template <typename Msg>
+        bool encode(write_cursor& dst, Msg const& msg) {
+            return dst.left() >= int(block_length<Msg>::value) &&
+                   encode_pass<fixed_pass>(dst, msg) &&
+                   encode_pass<group_pass>(dst, msg) &&
+                   encode_pass<var_pass>(dst, msg);
+        }
+        
+        /// Block bounds are checked once, fixed fields are read without checks
+        template <typename Msg>
+        bool decode(read_cursor& src, Msg& msg, size_t block) {
+            if(src.left() < int(block))
+                return false;
+            read_cursor fixed(src.pointer(), int(block));
+            decode_pass<fixed_pass>(fixed, msg);
+            src.step(int(block));
+            return decode_pass<group_pass>(src, msg) && decode_pass<var_pass>(src, msg);
+        }
+    } // details
+    
+    
+    /// ------------------------! Interface !------------------------ ///
+    
+    /// Size of fixed block of given msg_t
+    template <typename Msg>
+    constexpr size_t block_length() {
+        return details::block_length<Msg>::value; }
+    
+    /// Encodes message (block, groups, var-data), nothing is framed
+    template <typename Msg>
+    bool serialize_binary(write_cursor& dst, Msg const& msg) {
+        return details::encode(dst, msg); }
+    
+    /// Decodes message written by serialize_binary(), all fields are overwritten
+    template <typename Msg>
+    bool deserialize_binary(read_cursor& src, Msg& msg) {
+        return details::decode(src, msg, block_length<Msg>()); }
+    
+    /// Framing header + header + body, Length/CheckSum are carried as is
+    template <typename H, typename Msg>
+    bool serialize_binary_message(write_cursor& dst, H const& header, Msg const& msg) {
+        char* begin = dst.pointer();
+        if(dst.left() < framing_header_size)
+            return false;
+        dst.step(framing_header_size);
+        
+        if(!serialize_binary(dst, header) || !serialize_binary(dst, msg))
+            return false;
+        
+        std::uint32_t size = std::uint32_t(dst.pointer() - begin);
+        unsigned char* p = reinterpret_cast<unsigned char*>(begin);
+        p[0] = (size >> 24) & 0xFF;
+        p[1] = (size >> 16) & 0xFF;
+        p[2] = (size >> 8) & 0xFF;
+        p[3] = size & 0xFF;
+        p[4] = sbe_le_encoding >> 8;
+        p[5] = sbe_le_encoding & 0xFF;
+        return true;
+    }
+    
+    /**
+     * Finds binary message boundary using framing header.
+     * @returns full message size, 0 if more data is needed, -1 if data is malformed
+     */
+    inline int frame_binary(read_cursor const& src) {
+        if(src.left() < framing_header_size)
+            return 0;
+        
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(src.pointer());
+        std::uint32_t size = (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+                             (std::uint32_t(p[2]) << 8)  |  std::uint32_t(p[3]);
+        std::uint16_t encoding = std::uint16_t((p[4] << 8) | p[5]);
+        if(encoding != sbe_le_encoding || size < framing_header_size ||
+           size > std::uint32_t(std::numeric_limits<int>::max()))
+            return -1;
+        return size > std::uint32_t(src.left()) ? 0 : int(size);
+    }
+    
+    /// Decodes exactly one framed message, src is moved past it
+    template <typename H, typename Msg>
+    bool deserialize_binary_message(read_cursor& src, H& header, Msg& msg) {
+        int size = frame_binary(src);
+        if(size <= 0)
+            return false;
+        
+        read_cursor one(src.pointer() + framing_header_size, size - framing_header_size);
+        if(!deserialize_binary(one, header) || !deserialize_binary(one, msg) || one.left() != 0)
+            return false;
+        src.step(size);
+        return true;
+    }
+    
+    
+    /// ------------------------! Wire format conversion !------------------------ ///
+    
+    /// tag=value => binary: one framed message is parsed into given objects and re-encoded
+    template <typename H, typename Msg, typename T>
+    bool fix_to_binary(read_cursor& src, write_cursor& dst, H& header, Msg& msg, T& trailer) {
+        int size = dict::frame_message(src);
+        if(size <= 0)
+            return false;
+        
+        read_cursor one(src.pointer(), size);
+        if(!header.deserialize(one) || !msg.deserialize(one) || !trailer.deserialize(one) || one.left() != 0)
+            return false;
+        if(!serialize_binary_message(dst, header, msg))
+            return false;
+        src.step(size);
+        return true;
+    }
+    
+    /// binary => tag=value: Length and CheckSum are recalculated
+    template <typename H, typename Msg, typename T>
+    bool binary_to_fix(read_cursor& src, write_cursor& dst, H& header, Msg& msg, T& trailer) {
+        read_cursor tmp = src;
+        if(!deserialize_binary_message(tmp, header, msg) || !dict::serialize_message(dst, header, msg, trailer))
+            return false;
+        src = tmp;
+        return true;
+    }
+
+} // sbe
+} // preFIX
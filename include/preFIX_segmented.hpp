@@ -0,0 +1,356 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <preFIX.hpp>
+#include <preFIX_dict.hpp>
+
+namespace preFIX {
+    
+    /// Fixed-size blocks recycled through free list (single thread)
+    class block_pool {
+    private:
+        int block_size_;
+        std::vector<std::unique_ptr<char[]>> storage_;
+        std::vector<char*> free_;
+    
+    public:
+        explicit block_pool(int block_size, int preallocated = 0) : block_size_(block_size) {
+            for(int i = 0; i < preallocated; ++i)
+                release(acquire());
+        }
+        
+        block_pool(block_pool const&) = delete;
+        block_pool& operator=(block_pool const&) = delete;
+        
+        /// Takes free block or allocates new one
+        char* acquire() {
+            if(free_.empty()) {
+                storage_.emplace_back(new char[block_size_]);
+                return storage_.back().get();
+            }
+            char* block = free_.back();
+            free_.pop_back();
+            return block;
+        }
+        
+        void release(char* block) {
+            free_.push_back(block); }
+        
+        inline int block_size() const {
+            return block_size_; }
+        
+        /// Total number of allocated blocks
+        inline size_t allocated() const {
+            return storage_.size(); }
+        
+        inline size_t available() const {
+            return free_.size(); }
+    };
+    
+    
+    /**
+     * Output spanning chain of pool blocks, exported as iovec array for
+     * writev()/sendmsg() without coalescing. Every write goes through
+     * write_cursor of current block; write which doesn't fit is rolled back
+     * and repeated on a fresh block => values are never split (single value
+     * must fit into block), tails of blocks are just left unused.
+     */
+    class segmented_cursor {
+    private:
+        struct segment {
+            char* block;
+            int begin;
+            int end;
+        };
+        
+        struct as_value {};
+        struct as_message {};
+        struct as_group {};
+        
+        template <typename... T>
+        static std::true_type message_test(dict::msg_t<T...> const*);
+        static std::false_type message_test(...);
+        
+        template <int tag, typename... G>
+        static std::true_type group_test(dict::field_base<tag, dict::Group<G...>> const*);
+        static std::false_type group_test(...);
+        
+        template <typename V>
+        using kind_of = typename std::conditional<
+            decltype(message_test(static_cast<V const*>(nullptr)))::value, as_message,
+            typename std::conditional<
+                decltype(group_test(static_cast<V const*>(nullptr)))::value, as_group, as_value
+            >::type
+        >::type;
+        
+        block_pool& pool_;
+        std::deque<segment> segments_;  // last one is current
+        write_cursor current_;
+        int size_;
+        
+        void sync() {
+            size_ += current_.processed() - segments_.back().end;
+            segments_.back().end = current_.processed();
+        }
+        
+        /// Starts new segment, untouched current one is reused
+        void next_block() {
+            if(!segments_.empty() && current_.processed() == 0)
+                return;
+            
+            char* block = pool_.acquire();
+            segments_.push_back({block, 0, 0});
+            current_ = write_cursor(block, pool_.block_size());
+        }
+        
+        template <typename V>
+        bool put_impl(V const& value, as_value) {
+            return write([&value](write_cursor& dst) {
+                return value.serialize(dst); });
+        }
+        
+        /// Message is written field by field => may span several blocks
+        template <typename V>
+        bool put_impl(V const& msg, as_message) {
+            bool res = true;
+            msg.for_each([this, &res](auto const& field) {
+                res = res && this->put(field); });
+            return res;
+        }
+        
+        /// "TAG=NUM|" is written as one value, entries are written as messages
+        template <typename V>
+        bool put_impl(V const& group, as_group) {
+            if(!group.present())
+                return true;
+            
+            bool res = write([&group](write_cursor& dst) {
+                types::Int tag_val(V::tag);
+                types::Int group_size(group.value.size());
+                return types::serialize_tag(tag_val, dst) && group_size.serialize(dst);
+            });
+            
+            for(auto const& entry : group.value)
+                res = res && put(entry);
+            return res;
+        }
+    
+    public:
+        explicit segmented_cursor(block_pool& pool) :
+            pool_(pool), current_(nullptr, 0), size_(0) {}
+        
+        segmented_cursor(segmented_cursor const&) = delete;
+        segmented_cursor& operator=(segmented_cursor const&) = delete;
+        
+        ~segmented_cursor() {
+            reset(); }
+        
+        /**
+         * Calls f(write_cursor&) -> bool on current block, if it fails
+         * written bytes are dropped and f is repeated on a fresh block.
+         * @returns false if f fails on empty block too
+         */
+        template <typename F>
+        bool write(F&& f) {
+            if(!segments_.empty()) {
+                int mark = current_.processed();
+                if(f(current_)) {
+                    sync();
+                    return true;
+                }
+                current_.step(mark - current_.processed());
+            }
+            
+            next_block();
+            if(f(current_)) {
+                sync();
+                return true;
+            }
+            current_.reset();
+            return false;
+        }
+        
+        /// Serializes value, message (field by field) or group (entry by entry)
+        template <typename V>
+        bool put(V const& value) {
+            return put_impl(value, kind_of<V>{}); }
+        
+        /// Copies raw bytes, splitting them between blocks if necessary
+        bool append(char const* data, int size) {
+            while(size > 0) {
+                if(segments_.empty() || current_.left() == 0)
+                    next_block();
+                int chunk = std::min(size, current_.left());
+                std::memcpy(current_.pointer(), data, chunk);
+                current_.step(chunk);
+                sync();
+                data += chunk;
+                size -= chunk;
+            }
+            return true;
+        }
+        
+        /// Pending bytes
+        inline int size() const {
+            return size_; }
+        
+        inline size_t segments() const {
+            return segments_.size(); }
+        
+        /// Sum of bytes starting from given position (CheckSum calculation)
+        int byte_sum(int from = 0) const {
+            int sum = 0;
+            for(auto const& s : segments_) {
+                int len = s.end - s.begin;
+                if(from >= len) {
+                    from -= len;
+                    continue;
+                }
+                sum += sum_bytes(s.block + s.begin + from, len - from);
+                from = 0;
+            }
+            return sum;
+        }
+        
+        /// Drops bytes after given position (rollback of failed write)
+        void truncate(int new_size) {
+            while(size_ > new_size) {
+                auto& s = segments_.back();
+                int drop = std::min(size_ - new_size, s.end - s.begin);
+                s.end -= drop;
+                size_ -= drop;
+                if(s.end == s.begin && segments_.size() > 1) {
+                    pool_.release(s.block);
+                    segments_.pop_back();
+                }
+            }
+            if(!segments_.empty()) {
+                auto const& s = segments_.back();
+                current_ = write_cursor(s.block, pool_.block_size());
+                current_.step(s.end);
+            }
+        }
+        
+        /// Drops bytes from the front (sent ones), releases emptied blocks
+        void consume(int bytes) {
+            while(bytes > 0 && !segments_.empty()) {
+                auto& s = segments_.front();
+                int len = s.end - s.begin;
+                if(bytes < len) {
+                    s.begin += bytes;
+                    size_ -= bytes;
+                    return;
+                }
+                bytes -= len;
+                size_ -= len;
+                if(segments_.size() == 1) {
+                    s.begin = s.end; // keep current block
+                    return;
+                }
+                pool_.release(s.block);
+                segments_.pop_front();
+            }
+        }
+        
+        /// Fills up to max_count entries, @returns number of filled ones
+        int to_iovec(iovec* iov, int max_count) const {
+            int count = 0;
+            for(auto const& s : segments_) {
+                if(count == max_count)
+                    break;
+                if(s.end == s.begin)
+                    continue;
+                iov[count].iov_base = s.block + s.begin;
+                iov[count].iov_len = size_t(s.end - s.begin);
+                ++count;
+            }
+            return count;
+        }
+        
+        /**
+         * Single writev() of pending data, sent bytes are consumed.
+         * @returns written bytes or -1 (errno is set, EAGAIN => retry later)
+         */
+        int flush(int fd) {
+            enum : int { max_iov = 64 };
+            iovec iov[max_iov];
+            int count = to_iovec(iov, max_iov);
+            if(count == 0)
+                return 0;
+            
+            ssize_t res;
+            do {
+                res = ::writev(fd, iov, count);
+            } while(res < 0 && errno == EINTR);
+            
+            if(res > 0)
+                consume(int(res));
+            return int(res);
+        }
+        
+        /// Returns all blocks to pool
+        void reset() {
+            for(auto const& s : segments_)
+                pool_.release(s.block);
+            segments_.clear();
+            current_ = write_cursor(nullptr, 0);
+            size_ = 0;
+        }
+    };
+
+
+namespace dict {
+    
+    /// serialize_message() overload: message is appended to segmented output
+    template <typename H, typename Msg, typename T>
+    bool serialize_message(segmented_cursor& dst, H& header, Msg const& msg, T& trailer) {
+        int begin = dst.size();
+        int body_begin = 0;
+        char* length_ptr = nullptr;
+        int length_size = 0;
+        bool res = true;
+        
+        header.template set<Length>(0);
+        header.for_each([&](auto const& field) {
+            char* ptr = nullptr;
+            res = res && dst.write([&](write_cursor& wc) {
+                ptr = wc.pointer();
+                return field.serialize(wc);
+            });
+            if(std::is_same<std::decay_t<decltype(field)>, Length>::value) {
+                length_ptr = ptr;
+                length_size = dst.size() - begin;
+                body_begin = dst.size();
+            }
+        });
+        
+        res = res && length_ptr && dst.put(msg);
+        if(res) {
+            // Fixed width => Length is patched in place (field is never split)
+            header.template set<Length>(dst.size() - body_begin);
+            write_cursor lc(length_ptr, length_size);
+            res = header.template at<Length>().serialize(lc);
+        }
+        
+        if(res) {
+            trailer.template set<CheckSum>(dst.byte_sum(begin) % 256);
+            res = dst.put(trailer);
+        }
+        
+        if(!res)
+            dst.truncate(begin);
+        return res;
+    }
+
+} // dict
+} // preFIX
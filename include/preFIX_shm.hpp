@@ -0,0 +1,360 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <preFIX.hpp>
+#include <preFIX_dict.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace preFIX { namespace ipc {
+    
+    enum : size_t { cache_line = 64 };
+    
+    namespace details {
+        inline void cpu_relax() {
+        #if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+        #endif
+        }
+        
+        /// Spinning is pointless when peer can't run at the same time
+        inline int default_spin_count() {
+            static int const value = ::sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 10000 : 0;
+            return value;
+        }
+        
+        /// Process-shared futex (not FUTEX_PRIVATE_FLAG)
+        inline void futex_wait(std::atomic<std::uint32_t>* addr, std::uint32_t expected, int timeout_us) {
+            timespec ts;
+            ts.tv_sec = timeout_us/1000000;
+            ts.tv_nsec = long(timeout_us%1000000)*1000;
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(addr), FUTEX_WAIT,
+                      expected, timeout_us < 0 ? nullptr : &ts, nullptr, 0);
+        }
+        
+        inline void futex_wake(std::atomic<std::uint32_t>* addr) {
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(addr), FUTEX_WAKE,
+                      INT_MAX, nullptr, nullptr, 0);
+        }
+    } // details
+    
+    /**
+     * Multi-producer/single-consumer ring of fixed-size slots in a shared
+     * file (e.g. /dev/shm/...), one framed message per slot. Writers
+     * serialize straight into slot memory, reader decodes in place.
+     * Every slot carries sequence number (Vyukov bounded queue):
+     * seq == pos => free for producer of pos, seq == pos + 1 => ready.
+     * Counters live on separate cache lines; reader sleeps on futex
+     * after spinning.
+     * Usage:
+     *   auto slot = ring.try_reserve();
+     *   if(slot) {
+     *       serialize_message(slot.cursor, header, msg, trailer);
+     *       ring.commit(slot);
+     *   }
+     *   ...
+     *   ring.poll([](read_cursor& msg) { ... });
+     */
+    class shm_ring {
+    private:
+        enum : std::uint64_t { magic_value = 0x474E495258494650ULL }; // "PFIXRING"
+        
+        struct alignas(cache_line) header {
+            std::uint64_t magic;
+            std::uint32_t slot_size;    // payload bytes
+            std::uint32_t slot_count;   // power of 2
+            std::uint64_t stride;       // slot header + payload, cache line multiple
+            
+            alignas(cache_line) std::atomic<std::uint64_t> claim;   // producers
+            alignas(cache_line) std::atomic<std::uint64_t> read;    // consumer
+            alignas(cache_line) std::atomic<std::uint32_t> signal;  // futex word
+            std::atomic<std::uint32_t> waiting;
+            std::atomic<std::uint32_t> closed;
+        };
+        
+        struct alignas(cache_line) slot_header {
+            std::atomic<std::uint64_t> seq;
+            std::uint32_t size;
+        };
+        
+        header* hdr_ = nullptr;
+        char* slots_ = nullptr;
+        size_t mapped_ = 0;
+        
+        inline slot_header* slot_at(std::uint64_t pos) const {
+            return reinterpret_cast<slot_header*>(slots_ + (pos & (hdr_->slot_count - 1))*hdr_->stride); }
+        
+        static char* payload(slot_header* s) {
+            return reinterpret_cast<char*>(s) + sizeof(slot_header); }
+        
+        bool map(int fd, size_t size) {
+            void* area = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(area == MAP_FAILED)
+                return false;
+            
+            hdr_ = static_cast<header*>(area);
+            slots_ = static_cast<char*>(area) + sizeof(header);
+            mapped_ = size;
+            return true;
+        }
+    
+    public:
+        /// Claimed slot: fill cursor and commit() (or cancel()) it
+        struct slot {
+            write_cursor cursor;
+            std::uint64_t pos;
+            slot_header* ptr;
+            
+            explicit operator bool() const {
+                return ptr != nullptr; }
+        };
+        
+        shm_ring() = default;
+        shm_ring(shm_ring const&) = delete;
+        shm_ring& operator=(shm_ring const&) = delete;
+        
+        ~shm_ring() {
+            close(); }
+        
+        /// Creates (truncates) ring file, slot_count is rounded up to power of 2
+        bool create(std::string const& path, std::uint32_t slot_size, std::uint32_t slot_count) {
+            close();
+            
+            std::uint32_t count = 1;
+            while(count < slot_count)
+                count *= 2;
+            std::uint64_t stride = (sizeof(slot_header) + slot_size + cache_line - 1)/cache_line*cache_line;
+            size_t size = sizeof(header) + stride*count;
+            
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if(fd < 0)
+                return false;
+            if(::ftruncate(fd, off_t(size)) != 0) {
+                ::close(fd);
+                return false;
+            }
+            if(!map(fd, size))
+                return false;
+            
+            hdr_->slot_size = slot_size;
+            hdr_->slot_count = count;
+            hdr_->stride = stride;
+            hdr_->claim.store(0);
+            hdr_->read.store(0);
+            hdr_->signal.store(0);
+            hdr_->waiting.store(0);
+            hdr_->closed.store(0);
+            for(std::uint64_t i = 0; i < count; ++i)
+                slot_at(i)->seq.store(i, std::memory_order_relaxed);
+            
+            std::atomic_thread_fence(std::memory_order_release);
+            reinterpret_cast<std::atomic<std::uint64_t>*>(&hdr_->magic)->store(magic_value, std::memory_order_release);
+            return true;
+        }
+        
+        /// Attaches to ring created by another process
+        bool open(std::string const& path) {
+            close();
+            
+            int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+            if(fd < 0)
+                return false;
+            
+            struct stat st;
+            if(::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(header)) {
+                ::close(fd);
+                return false;
+            }
+            if(!map(fd, size_t(st.st_size)))
+                return false;
+            
+            if(reinterpret_cast<std::atomic<std::uint64_t>*>(&hdr_->magic)->load(std::memory_order_acquire) != magic_value ||
+               sizeof(header) + hdr_->stride*hdr_->slot_count > mapped_) {
+                close();
+                return false;
+            }
+            return true;
+        }
+        
+        void close() {
+            if(hdr_)
+                ::munmap(hdr_, mapped_);
+            hdr_ = nullptr;
+            slots_ = nullptr;
+            mapped_ = 0;
+        }
+        
+        inline bool is_open() const {
+            return hdr_ != nullptr; }
+        
+        inline std::uint32_t slot_size() const {
+            return hdr_->slot_size; }
+        
+        inline std::uint32_t slot_count() const {
+            return hdr_->slot_count; }
+        
+        
+        /// ------------------------! Producers !------------------------ ///
+        
+        /// Claims next slot, empty result if ring is full
+        slot try_reserve() {
+            std::uint64_t pos = hdr_->claim.load(std::memory_order_relaxed);
+            for(;;) {
+                slot_header* s = slot_at(pos);
+                std::uint64_t seq = s->seq.load(std::memory_order_acquire);
+                std::int64_t diff = std::int64_t(seq) - std::int64_t(pos);
+                if(diff == 0) {
+                    if(hdr_->claim.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        return slot{write_cursor(payload(s), int(hdr_->slot_size)), pos, s};
+                } else if(diff < 0) {
+                    return slot{write_cursor(nullptr, 0), 0, nullptr}; // full
+                } else {
+                    pos = hdr_->claim.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        
+        /// Spins (yielding to consumer every spin_count tries) until slot is available
+        slot reserve(int spin_count = details::default_spin_count()) {
+            for(int i = 1;; ++i) {
+                slot s = try_reserve();
+                if(s)
+                    return s;
+                if(i > spin_count) {
+                    ::sched_yield();
+                    i = 0;
+                } else {
+                    details::cpu_relax();
+                }
+            }
+        }
+        
+        /// Publishes slot with cursor.processed() bytes
+        void commit(slot& s) {
+            s.ptr->size = std::uint32_t(s.cursor.processed());
+            s.ptr->seq.store(s.pos + 1, std::memory_order_release);
+            
+            hdr_->signal.fetch_add(1, std::memory_order_seq_cst);
+            if(hdr_->waiting.load(std::memory_order_seq_cst))
+                details::futex_wake(&hdr_->signal);
+            s.ptr = nullptr;
+        }
+        
+        /// Publishes empty slot (claimed slot can't be abandoned), reader skips it
+        void cancel(slot& s) {
+            s.cursor.reset();
+            commit(s);
+        }
+        
+        /// Serializes message into next slot, @returns false if full or too large
+        template <typename H, typename Msg, typename T>
+        bool send(H& header, Msg const& msg, T& trailer) {
+            slot s = try_reserve();
+            if(!s)
+                return false;
+            if(!dict::serialize_message(s.cursor, header, msg, trailer)) {
+                cancel(s);
+                return false;
+            }
+            commit(s);
+            return true;
+        }
+        
+        /// Marks ring closed for consumer (all producers are done)
+        void shutdown() {
+            hdr_->closed.store(1, std::memory_order_release);
+            hdr_->signal.fetch_add(1, std::memory_order_seq_cst);
+            details::futex_wake(&hdr_->signal);
+        }
+        
+        
+        /// ------------------------! Consumer !------------------------ ///
+        
+        inline bool closed() const {
+            return hdr_->closed.load(std::memory_order_acquire) != 0; }
+        
+        inline bool ready() const {
+            std::uint64_t pos = hdr_->read.load(std::memory_order_relaxed);
+            return slot_at(pos)->seq.load(std::memory_order_acquire) == pos + 1;
+        }
+        
+        /**
+         * Calls f(read_cursor&) for up to max ready messages (in place),
+         * slots are released after f returns. @returns number of messages
+         */
+        template <typename F>
+        size_t poll(F&& f, size_t max = size_t(-1)) {
+            std::uint64_t pos = hdr_->read.load(std::memory_order_relaxed);
+            size_t n = 0;
+            while(n < max) {
+                slot_header* s = slot_at(pos);
+                if(s->seq.load(std::memory_order_acquire) != pos + 1)
+                    break;
+                
+                if(s->size > 0) {
+                    read_cursor msg(payload(s), int(s->size));
+                    f(msg);
+                    ++n;
+                }
+                
+                s->seq.store(pos + hdr_->slot_count, std::memory_order_release);
+                hdr_->read.store(++pos, std::memory_order_relaxed);
+            }
+            return n;
+        }
+        
+        /**
+         * Spins spin_count times (0 on single CPU), then sleeps on futex until
+         * message arrives, ring is closed or timeout expires. @returns ready()
+         * Wakeup may come from commit of later slot while the next one is still
+         * being filled by another producer => sleeps again until deadline.
+         */
+        bool wait(int timeout_us = -1, int spin_count = details::default_spin_count()) {
+            for(int i = 0; i < spin_count; ++i) {
+                if(ready() || closed())
+                    return ready();
+                details::cpu_relax();
+            }
+            
+            using clock = std::chrono::steady_clock;
+            auto deadline = clock::now() + std::chrono::microseconds(timeout_us);
+            while(!ready() && !closed()) {
+                int left = -1;
+                if(timeout_us >= 0) {
+                    auto us = std::chrono::duration_cast<std::chrono::microseconds>(deadline - clock::now()).count();
+                    if(us <= 0)
+                        break;
+                    left = int(us);
+                }
+                
+                std::uint32_t key = hdr_->signal.load(std::memory_order_acquire);
+                hdr_->waiting.store(1, std::memory_order_seq_cst);
+                if(!ready() && !closed())
+                    details::futex_wait(&hdr_->signal, key, left);
+                hdr_->waiting.store(0, std::memory_order_relaxed);
+            }
+            return ready();
+        }
+    };
+
+} // ipc
+} // preFIX
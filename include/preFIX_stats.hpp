@@ -0,0 +1,245 @@
+#pragma once
+
+/**
+ * Hot path instrumentation, compiled in only with PREFIX_INSTRUMENT defined
+ * (otherwise all PREFIX_STATS_* hooks expand to nothing and nothing else is
+ * declared). Collected per type: calls, cycles and bytes of
+ * serialize/deserialize, unknown tags met by msg_t, allocations made by
+ * Group/String values.
+ */
+#ifdef PREFIX_INSTRUMENT
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <preFIX.hpp>
+
+namespace preFIX { namespace stats {
+    
+    using counter = std::atomic<std::uint64_t>;
+    
+    struct counters {
+        counter serialize_calls{0};
+        counter serialize_cycles{0};
+        counter bytes_out{0};
+        
+        counter deserialize_calls{0};
+        counter deserialize_cycles{0};
+        counter bytes_in{0};
+        
+        counter failures{0};
+        counter unknown_tags{0};   // tags not belonging to msg_t (includes group ends)
+        counter allocations{0};
+        
+        void reset() {
+            for(counter* c : {&serialize_calls, &serialize_cycles, &bytes_out,
+                              &deserialize_calls, &deserialize_cycles, &bytes_in,
+                              &failures, &unknown_tags, &allocations})
+                c->store(0, std::memory_order_relaxed);
+        }
+    };
+    
+    /// Registered instrumented type
+    struct entry {
+        std::string name;
+        char const* kind;           // "msg", "group", "value"
+        counters data;
+    };
+    
+    /// Process-wide storage of all counters
+    class registry {
+    private:
+        mutable std::mutex mutex_;
+        std::deque<entry> entries_;  // stable addresses
+        
+        registry() = default;
+    
+    public:
+        static registry& instance() {
+            static registry r;
+            return r;
+        }
+        
+        entry& add(std::string name, char const* kind) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.emplace_back();
+            entries_.back().name = std::move(name);
+            entries_.back().kind = kind;
+            return entries_.back();
+        }
+        
+        /// Calls f(entry const&) for every registered type
+        template <typename F>
+        void for_each(F&& f) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for(auto const& e : entries_)
+                f(e);
+        }
+        
+        entry const* find(std::string const& name) const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for(auto const& e : entries_)
+                if(e.name == name)
+                    return &e;
+            return nullptr;
+        }
+        
+        void reset() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for(auto& e : entries_)
+                e.data.reset();
+        }
+        
+        void rename(entry& e, std::string name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            e.name = std::move(name);
+        }
+        
+        /// Human readable table (type names are appended as is, they may be long)
+        std::string report() const {
+            std::string res;
+            char line[256];
+            std::snprintf(line, sizeof(line), "%-6s %10s %12s %10s %10s %12s %10s %8s %8s %6s  %s\n",
+                "kind", "ser", "ser_cyc", "bytes_out", "deser", "deser_cyc", "bytes_in",
+                "unknown", "allocs", "fails", "type");
+            res += line;
+            
+            for_each([&](entry const& e) {
+                auto ld = [](counter const& c) { return (unsigned long long)c.load(std::memory_order_relaxed); };
+                std::snprintf(line, sizeof(line), "%-6s %10llu %12llu %10llu %10llu %12llu %10llu %8llu %8llu %6llu  ",
+                    e.kind, ld(e.data.serialize_calls), ld(e.data.serialize_cycles), ld(e.data.bytes_out),
+                    ld(e.data.deserialize_calls), ld(e.data.deserialize_cycles), ld(e.data.bytes_in),
+                    ld(e.data.unknown_tags), ld(e.data.allocations), ld(e.data.failures));
+                res += line;
+                res += e.name;
+                res += '\n';
+            });
+            return res;
+        }
+    };
+    
+    template <typename T>
+    std::string type_name() {
+        char const* raw = typeid(T).name();
+    #if defined(__GNUG__)
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(raw, nullptr, nullptr, &status);
+        if(status == 0 && demangled) {
+            std::string res(demangled);
+            std::free(demangled);
+            return res;
+        }
+    #endif
+        return raw;
+    }
+    
+    /// Kind of instrumented type, specialized where types are defined
+    template <typename T>
+    struct kind_of {
+        static char const* value() { return "value"; } };
+    
+    /// Entry of given type (registered on first use)
+    template <typename T>
+    entry& of() {
+        static entry& e = registry::instance().add(type_name<T>(), kind_of<T>::value());
+        return e;
+    }
+    
+    /// Renames entry of given type (demangled names of msg_t are long)
+    template <typename T>
+    void set_name(std::string name) {
+        registry::instance().rename(of<T>(), std::move(name)); }
+    
+    inline std::uint64_t cycles() {
+    #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+    #else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+    }
+    
+    /// Measures one serialize/deserialize call
+    template <typename Cursor>
+    class op_scope {
+    private:
+        counter& calls_;
+        counter& cycles_;
+        counter& bytes_;
+        Cursor const& cursor_;
+        int processed_;
+        std::uint64_t start_;
+    
+    public:
+        op_scope(counter& calls, counter& cyc, counter& bytes, Cursor const& cursor) :
+            calls_(calls), cycles_(cyc), bytes_(bytes), cursor_(cursor),
+            processed_(cursor.processed()), start_(stats::cycles()) {}
+        
+        ~op_scope() {
+            cycles_.fetch_add(stats::cycles() - start_, std::memory_order_relaxed);
+            calls_.fetch_add(1, std::memory_order_relaxed);
+            bytes_.fetch_add(cursor_.processed() - processed_, std::memory_order_relaxed);
+        }
+    };
+    
+    /// Capacity of value's dynamic storage (allocation detection)
+    template <typename T>
+    inline size_t capacity_of(T const&) {
+        return 0; }
+    
+    inline size_t capacity_of(String_underlying const& s) {
+        return s.capacity(); }
+
+} // stats
+} // preFIX
+
+#define PREFIX_STATS_CONCAT_IMPL(a, b) a##b
+#define PREFIX_STATS_CONCAT(a, b) PREFIX_STATS_CONCAT_IMPL(a, b)
+
+/// Times enclosing scope as serialization of T into cursor
+#define PREFIX_STATS_SERIALIZE(T, cursor) \
+    auto& PREFIX_STATS_CONCAT(prefix_stats_, __LINE__) = ::preFIX::stats::of<T>().data; \
+    ::preFIX::stats::op_scope<typename std::decay<decltype(cursor)>::type> \
+        PREFIX_STATS_CONCAT(prefix_scope_, __LINE__)( \
+            PREFIX_STATS_CONCAT(prefix_stats_, __LINE__).serialize_calls, \
+            PREFIX_STATS_CONCAT(prefix_stats_, __LINE__).serialize_cycles, \
+            PREFIX_STATS_CONCAT(prefix_stats_, __LINE__).bytes_out, cursor)
+
+/// Times enclosing scope as deserialization of T from cursor
+#define PREFIX_STATS_DESERIALIZE(T, cursor) \
+    auto& PREFIX_STATS_CONCAT(prefix_stats_, __LINE__) = ::preFIX::stats::of<T>().data; \
+    ::preFIX::stats::op_scope<typename std::decay<decltype(cursor)>::type> \
+        PREFIX_STATS_CONCAT(prefix_scope_, __LINE__)( \
+            PREFIX_STATS_CONCAT(prefix_stats_, __LINE__).deserialize_calls, \
+            PREFIX_STATS_CONCAT(prefix_stats_, __LINE__).deserialize_cycles, \
+            PREFIX_STATS_CONCAT(prefix_stats_, __LINE__).bytes_in, cursor)
+
+#define PREFIX_STATS_ADD(T, field, n) \
+    ::preFIX::stats::of<T>().data.field.fetch_add((n), std::memory_order_relaxed)
+
+/// Evaluates expression only if instrumentation is enabled
+#define PREFIX_STATS_ONLY(...) __VA_ARGS__
+
+#else
+
+#define PREFIX_STATS_SERIALIZE(T, cursor)   ((void)0)
+#define PREFIX_STATS_DESERIALIZE(T, cursor) ((void)0)
+#define PREFIX_STATS_ADD(T, field, n)       ((void)0)
+#define PREFIX_STATS_ONLY(...)
+
+#endif
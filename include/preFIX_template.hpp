@@ -0,0 +1,204 @@
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <preFIX.hpp>
+#include <preFIX_dict.hpp>
+
+namespace preFIX { namespace dict {
+    
+    namespace details {
+        /// true if T is one of List...
+        template <typename T, typename... List>
+        struct type_in : std::false_type {};
+        
+        template <typename T, typename... List>
+        struct type_in<T, T, List...> : std::true_type {};
+        
+        template <typename T, typename U, typename... List>
+        struct type_in<T, U, List...> : type_in<T, List...> {};
+    } // details
+    
+    /**
+     * Pre-rendered message: header+body fields which are not listed in Var...
+     * are encoded once by build(), at send time only Var... fields are
+     * serialized between constant chunks, Length and CheckSum are patched.
+     * Output is byte-identical to serialize_message(dst, header, msg, trailer).
+     * Example:
+     *   msg_template<Header, NewOrderSingle, MsgSeqNum, SendingTime, ClOrdID, Price> t;
+     *   t.build(header, nos);
+     *   ...
+     *   t.serialize(dst, header, nos);
+     */
+    template <typename H, typename Msg, typename... Var>
+    class msg_template {
+        static_assert(!details::type_in<Length, Var...>::value, "Length is patched automatically");
+    
+    private:
+        using render_fn = bool (*)(write_cursor&, H const&, Msg const&);
+        
+        /// Variable field placed after constant_[.., chunk_end)
+        struct slot {
+            int chunk_end;
+            render_fn render;
+        };
+        
+        std::vector<char> constant_;
+        std::vector<slot> slots_;
+        
+        int length_pos_;    // Length digits offset inside constant_
+        int length_width_;  // Length digits count
+        int constant_sum_;  // sum of constant bytes (Length digits as '0')
+        bool built_;
+        
+        template <typename F>
+        static bool render_header(write_cursor& dst, H const& h, Msg const&) {
+            return h.template at<F>().serialize(dst); }
+        
+        template <typename F>
+        static bool render_body(write_cursor& dst, H const&, Msg const& m) {
+            return m.template at<F>().serialize(dst); }
+        
+        template <typename F>
+        static render_fn renderer(std::true_type /* header */) {
+            return &render_header<F>; }
+        
+        template <typename F>
+        static render_fn renderer(std::false_type /* header */) {
+            return &render_body<F>; }
+        
+        /// Appends encoded field to constant_, @returns written size
+        template <typename F>
+        int append(F const& field) {
+            size_t used = constant_.size();
+            for(size_t cap = 256;; cap *= 2) {
+                constant_.resize(used + cap);
+                write_cursor wc(constant_.data() + used, cap);
+                if(field.serialize(wc)) {
+                    constant_.resize(used + wc.processed());
+                    return wc.processed();
+                }
+            }
+        }
+        
+        template <typename F>
+        void add(F const& field, render_fn, std::false_type /* variable */) {
+            append(field); }
+        
+        template <typename F>
+        void add(F const&, render_fn render, std::true_type /* variable */) {
+            slots_.push_back({int(constant_.size()), render}); }
+        
+        /// "9=" + zero digits + SOH, digits are patched by serialize()
+        /// Length offset in output must be constant => no variable fields before it
+        void add(Length const&, render_fn, std::false_type) {
+            if(!slots_.empty())
+                return;
+            Length zero;
+            zero.value = 0;
+            int size = append(zero);
+            length_pos_ = int(constant_.size()) - size + 2;
+            length_width_ = size - 3;
+        }
+        
+        template <bool is_header>
+        struct builder {
+            msg_template& self;
+            
+            template <typename F>
+            void operator()(F const& field) const {
+                using variable = details::type_in<F, Var...>;
+                self.add(field, renderer<F>(std::integral_constant<bool, is_header>{}), variable{});
+            }
+        };
+    
+    public:
+        msg_template() : length_pos_(-1), length_width_(0), constant_sum_(0), built_(false) {}
+        
+        /// Pre-renders constant parts of given prototypes, false if Var... precede Length
+        bool build(H const& header, Msg const& msg) {
+            constant_.clear();
+            slots_.clear();
+            length_pos_ = -1;
+            
+            header.for_each(builder<true> {*this});
+            msg.for_each(builder<false>{*this});
+            
+            if(length_pos_ < 0)
+                return built_ = false;
+            
+            constant_sum_ = sum_bytes(constant_.data(), constant_.size());
+            
+            return built_ = true;
+        }
+        
+        bool built() const {
+            return built_; }
+        
+        /// Encodes full message (header+body+trailer) taking Var... values from header/msg,
+        /// false if it doesn't fit dst or body is longer than Length width allows
+        bool serialize(write_cursor& dst, H const& header, Msg const& msg) const {
+            if(!built_)
+                return false;
+            
+            char* begin = dst.pointer();
+            int sum = constant_sum_;
+            int pos = 0;
+            
+            auto copy_chunk = [&](int end) {
+                int size = end - pos;
+                if(dst.left() < size)
+                    return false;
+                std::memcpy(dst.pointer(), constant_.data() + pos, size);
+                dst.step(size);
+                pos = end;
+                return true;
+            };
+            
+            for(auto const& s : slots_) {
+                if(!copy_chunk(s.chunk_end))
+                    return false;
+                
+                char* var = dst.pointer();
+                if(!s.render(dst, header, msg))
+                    return false;
+                
+                sum += sum_bytes(var, dst.pointer() - var);
+            }
+            
+            if(!copy_chunk(int(constant_.size())))
+                return false;
+            
+            // Length: bytes after "9=XXXXX<SOH>"
+            int body_start = length_pos_ + length_width_ + 1;
+            int length = int(dst.pointer() - begin) - body_start;
+            for(int i = length_width_ - 1; i >= 0; --i, length /= 10) {
+                char digit = '0' + length%10;
+                begin[length_pos_ + i] = digit;
+                sum += digit - '0';
+            }
+            if(length != 0)
+                return false;   // body doesn't fit Length width
+            
+            // CheckSum: "10=XXX<SOH>"
+            if(dst.left() < 7)
+                return false;
+            
+            sum %= 256;
+            char* ptr = dst.pointer();
+            ptr[0] = '1';
+            ptr[1] = '0';
+            ptr[2] = '=';
+            ptr[3] = '0' + sum/100;
+            ptr[4] = '0' + sum/10%10;
+            ptr[5] = '0' + sum%10;
+            ptr[6] = SOH;
+            dst.step(7);
+            return true;
+        }
+    };
+
+} // dict
+} // preFIX
@@ -0,0 +1,475 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <preFIX.hpp>
+#include <preFIX_dict.hpp>
+#include <preFIX_segmented.hpp>
+
+/**
+ * Optional Linux TCP transport: non-blocking sockets, edge-triggered epoll,
+ * receive into per-connection mirrored ring buffers, messages are framed
+ * and handed over as read_cursor pointing into the ring (no copies).
+ * Outbound messages are serialized into segmented output and sent by
+ * writev() once per poll iteration (batching).
+ */
+namespace preFIX { namespace net {
+    
+    /**
+     * Ring buffer mapped twice back-to-back (memfd): readable and writable
+     * spans are always contiguous, even across the wrap point.
+     */
+    class mirrored_ring {
+    private:
+        char* data_ = nullptr;
+        size_t size_ = 0;   // power of 2, multiple of page size
+        size_t head_ = 0;   // read position (monotonic)
+        size_t tail_ = 0;   // write position (monotonic)
+    
+    public:
+        mirrored_ring() = default;
+        mirrored_ring(mirrored_ring const&) = delete;
+        mirrored_ring& operator=(mirrored_ring const&) = delete;
+        
+        ~mirrored_ring() {
+            close(); }
+        
+        /// Maps at least min_size bytes, @returns false on failure
+        bool open(size_t min_size) {
+            close();
+            
+            size_t size = size_t(::sysconf(_SC_PAGESIZE));
+            while(size < min_size)
+                size *= 2;
+            
+            int fd = int(::syscall(SYS_memfd_create, "preFIX_ring", 0));
+            if(fd < 0)
+                return false;
+            
+            void* area = MAP_FAILED;
+            if(::ftruncate(fd, off_t(size)) == 0)
+                area = ::mmap(nullptr, 2*size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            
+            bool res = (area != MAP_FAILED);
+            char* base = static_cast<char*>(area);
+            for(int i = 0; res && i < 2; ++i)
+                res = ::mmap(base + i*size, size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+            ::close(fd);
+            
+            if(!res) {
+                if(area != MAP_FAILED)
+                    ::munmap(area, 2*size);
+                return false;
+            }
+            
+            data_ = base;
+            size_ = size;
+            head_ = tail_ = 0;
+            return true;
+        }
+        
+        void close() {
+            if(data_)
+                ::munmap(data_, 2*size_);
+            data_ = nullptr;
+            size_ = head_ = tail_ = 0;
+        }
+        
+        inline size_t capacity() const {
+            return size_; }
+        
+        inline char* write_ptr() {
+            return data_ + (tail_ & (size_ - 1)); }
+        
+        inline size_t writable() const {
+            return size_ - (tail_ - head_); }
+        
+        inline void produce(size_t n) {
+            tail_ += n; }
+        
+        inline char const* read_ptr() const {
+            return data_ + (head_ & (size_ - 1)); }
+        
+        inline size_t readable() const {
+            return tail_ - head_; }
+        
+        inline void consume(size_t n) {
+            head_ += n; }
+    };
+    
+    
+    struct options {
+        size_t ring_size    = 1 << 20;  // per connection receive buffer
+        int block_size      = 64 << 10; // outbound segment size
+        int max_events      = 64;
+        bool busy_poll      = false;    // run(): epoll_wait() without sleeping
+        int busy_poll_us    = 50;       // SO_BUSY_POLL (if permitted)
+    };
+    
+    
+    class connection {
+    private:
+        template <typename> friend class reactor;
+        
+        int fd_;
+        bool listener_;
+        bool connected_ = false;
+        bool closing_ = false;
+        bool dirty_ = false;
+        mirrored_ring in_;
+        segmented_cursor out_;
+        std::vector<connection*>* dirty_list_;
+        
+        void mark_dirty() {
+            if(!dirty_) {
+                dirty_ = true;
+                dirty_list_->push_back(this);
+            }
+        }
+    
+    public:
+        void* user = nullptr;   // user context
+        
+        connection(int fd, bool listener, block_pool& pool, std::vector<connection*>& dirty_list) :
+            fd_(fd), listener_(listener), out_(pool), dirty_list_(&dirty_list) {}
+        
+        connection(connection const&) = delete;
+        connection& operator=(connection const&) = delete;
+        
+        ~connection() {
+            out_.reset();
+            if(fd_ >= 0)
+                ::close(fd_);
+        }
+        
+        inline int fd() const {
+            return fd_; }
+        
+        inline bool connected() const {
+            return connected_ && !closing_; }
+        
+        /// Queues message, it's sent at the end of current poll() or by flush()
+        template <typename H, typename Msg, typename T>
+        bool send(H& header, Msg const& msg, T& trailer) {
+            if(!connected() || !dict::serialize_message(out_, header, msg, trailer))
+                return false;
+            mark_dirty();
+            return true;
+        }
+        
+        /// Queues already encoded bytes
+        bool send_raw(char const* data, int size) {
+            if(!connected() || !out_.append(data, size))
+                return false;
+            mark_dirty();
+            return true;
+        }
+        
+        /// Bytes waiting for socket
+        inline int pending() const {
+            return out_.size(); }
+        
+        /// Writes queued data until done or EAGAIN, @returns false on socket error
+        bool flush() {
+            while(out_.size() > 0) {
+                int res = out_.flush(fd_);
+                if(res < 0)
+                    return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            return true;
+        }
+        
+        /// Deferred close (safe inside handler callbacks)
+        void close() {
+            closing_ = true;
+            mark_dirty();
+        }
+    };
+    
+    
+    /**
+     * Event loop. Handler interface:
+     *   void on_connect(connection&);                  // accepted or connected
+     *   void on_message(connection&, read_cursor&);    // exactly one framed message
+     *   void on_close(connection&);
+     * read_cursor points into receive ring and is valid during the call only.
+     * Malformed framing or message larger than ring closes connection.
+     */
+    template <typename Handler>
+    class reactor {
+    private:
+        Handler& handler_;
+        options opt_;
+        int epfd_;
+        block_pool pool_;
+        std::unordered_map<int, std::unique_ptr<connection>> conns_;
+        std::vector<connection*> dirty_;
+        std::vector<epoll_event> events_;
+        
+        connection* add(int fd, bool listener, bool connected) {
+            std::unique_ptr<connection> conn(new connection(fd, listener, pool_, dirty_));
+            
+            epoll_event ev{};
+            ev.events = listener ? EPOLLIN : (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+            ev.data.ptr = conn.get();
+            if((!listener && !conn->in_.open(opt_.ring_size)) ||
+               ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                conn->fd_ = -1; // closed by caller
+                return nullptr;
+            }
+            
+            connection* res = conn.get();
+            conn->connected_ = connected;
+            conns_[fd] = std::move(conn);
+            return res;
+        }
+        
+        void tune(int fd) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        #ifdef SO_BUSY_POLL
+            if(opt_.busy_poll)
+                ::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &opt_.busy_poll_us, sizeof(opt_.busy_poll_us));
+        #endif
+        }
+        
+        void destroy(connection* c) {
+            if(!c->listener_)
+                handler_.on_close(*c);
+            ::epoll_ctl(epfd_, EPOLL_CTL_DEL, c->fd_, nullptr);
+            dirty_.erase(std::remove(dirty_.begin(), dirty_.end(), c), dirty_.end());
+            conns_.erase(c->fd_);
+        }
+        
+        void accept_all(connection& listener) {
+            for(;;) {
+                int fd = ::accept4(listener.fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if(fd < 0) {
+                    if(errno == EINTR || errno == ECONNABORTED)
+                        continue;
+                    return;
+                }
+                tune(fd);
+                connection* c = add(fd, false, true);
+                if(!c) {
+                    ::close(fd);
+                    continue;
+                }
+                handler_.on_connect(*c);
+            }
+        }
+        
+        /// Frames and dispatches complete messages, @returns false on malformed data
+        bool dispatch(connection& c) {
+            while(c.in_.readable() > 0 && !c.closing_) {
+                read_cursor src(c.in_.read_ptr(), int(c.in_.readable()));
+                int size = dict::frame_message(src);
+                if(size == 0)
+                    return true;
+                if(size < 0)
+                    return false;
+                
+                read_cursor msg(c.in_.read_ptr(), size);
+                handler_.on_message(c, msg);
+                c.in_.consume(size);
+            }
+            return true;
+        }
+        
+        /// Reads until EAGAIN (edge-triggered), @returns false if connection is done
+        bool receive(connection& c) {
+            for(;;) {
+                size_t space = c.in_.writable();
+                if(space == 0)
+                    return false; // message doesn't fit into ring
+                
+                ssize_t n = ::recv(c.fd_, c.in_.write_ptr(), space, 0);
+                if(n > 0) {
+                    c.in_.produce(size_t(n));
+                    if(!dispatch(c))
+                        return false;
+                    continue;
+                }
+                if(n == 0)
+                    return false;
+                if(errno == EINTR)
+                    continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+        }
+        
+        void handle(connection& c, std::uint32_t events) {
+            if(c.listener_) {
+                accept_all(c);
+                return;
+            }
+            
+            if(!c.connected_ && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                ::getsockopt(c.fd_, SOL_SOCKET, SO_ERROR, &err, &len);
+                if(err != 0) {
+                    c.closing_ = true;
+                    return;
+                }
+                c.connected_ = true;
+                handler_.on_connect(c);
+            }
+            
+            if((events & EPOLLIN) && !receive(c))
+                c.closing_ = true;
+            if((events & EPOLLOUT) && !c.flush())
+                c.closing_ = true;
+            if(events & (EPOLLERR | EPOLLHUP))
+                c.closing_ = true;
+        }
+    
+    public:
+        explicit reactor(Handler& handler, options const& opt = options()) :
+            handler_(handler), opt_(opt), epfd_(::epoll_create1(EPOLL_CLOEXEC)),
+            pool_(opt.block_size), events_(size_t(opt.max_events)) {}
+        
+        reactor(reactor const&) = delete;
+        reactor& operator=(reactor const&) = delete;
+        
+        ~reactor() {
+            while(!conns_.empty())
+                destroy(conns_.begin()->second.get());
+            if(epfd_ >= 0)
+                ::close(epfd_);
+        }
+        
+        inline bool ok() const {
+            return epfd_ >= 0; }
+        
+        /// Starts listening on IPv4 address (port 0 => ephemeral), @returns fd or -1
+        int listen(char const* host, std::uint16_t port, int backlog = 128) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if(::inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+                return -1;
+            
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if(fd < 0)
+                return -1;
+            
+            int one = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+               ::listen(fd, backlog) != 0 || !add(fd, true, false)) {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+        
+        /// Local port of listening/connected socket (0 on error)
+        static std::uint16_t local_port(int fd) {
+            sockaddr_in addr{};
+            socklen_t len = sizeof(addr);
+            if(::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+                return 0;
+            return ntohs(addr.sin_port);
+        }
+        
+        /// Starts non-blocking connect, on_connect() is called when established
+        connection* connect(char const* host, std::uint16_t port) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if(::inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+                return nullptr;
+            
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if(fd < 0)
+                return nullptr;
+            tune(fd);
+            
+            int res = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            if(res != 0 && errno != EINPROGRESS) {
+                ::close(fd);
+                return nullptr;
+            }
+            
+            connection* c = add(fd, false, false);
+            if(!c)
+                ::close(fd);
+            return c;
+        }
+        
+        /// Sends queued output of all connections, destroys closed ones
+        void flush() {
+            auto dirty = std::move(dirty_);
+            dirty_.clear();
+            
+            // EAGAIN leaves data queued, EPOLLOUT edge will flush it
+            for(connection* c : dirty) {
+                c->dirty_ = false;
+                if(!c->closing_ && c->connected_ && !c->flush())
+                    c->closing_ = true;
+            }
+            
+            for(connection* c : dirty)
+                if(c->closing_)
+                    destroy(c);
+            
+            // Capacity goes back => no allocation in steady state
+            if(dirty_.empty()) {
+                dirty.clear();
+                dirty_.swap(dirty);
+            }
+        }
+        
+        /**
+         * Waits for events (timeout_ms: -1 infinite, 0 non-blocking),
+         * handles them and flushes queued output. @returns number of events or -1
+         */
+        int poll(int timeout_ms) {
+            int n = ::epoll_wait(epfd_, events_.data(), int(events_.size()), timeout_ms);
+            if(n < 0)
+                return errno == EINTR ? 0 : -1;
+            
+            for(int i = 0; i < n; ++i) {
+                auto c = static_cast<connection*>(events_[i].data.ptr);
+                handle(*c, events_[i].events);
+                if(c->closing_)
+                    c->mark_dirty();
+            }
+            
+            flush();
+            return n;
+        }
+        
+        /// Polls until stop() returns true (busy polling if configured)
+        template <typename Stop>
+        void run(Stop&& stop) {
+            int timeout = opt_.busy_poll ? 0 : 1;
+            while(!stop())
+                if(poll(timeout) < 0)
+                    return;
+        }
+        
+        inline size_t connections() const {
+            return conns_.size(); }
+    };
+
+} // net
+} // preFIX
@@ -1,21 +1,117 @@
 #include <ax.hpp>
 
+#define PREFIX_ALLOC_HOOKS
+#include <preFIX_alloc.hpp>
+
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
 #include <list>
 #include <map>
 #include <memory>
 #include <fstream>
+#include <functional>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
+#include <sys/wait.h>
+
 #include <preFIX.hpp>
+#include <preFIX_cache.hpp>
 #include <preFIX_dict.hpp>
+#include <preFIX_journal.hpp>
+#include <preFIX_md.hpp>
+#include <preFIX_pcap.hpp>
+#include <preFIX_pool.hpp>
+#include <preFIX_sbe.hpp>
+#include <preFIX_segmented.hpp>
+#include <preFIX_shm.hpp>
+#include <preFIX_template.hpp>
+#include <preFIX_transport.hpp>
+
+#include <preFIX_fix44_subset.hpp> // generated by AX_PREFIX_DICTGEN
 
 using namespace ax;
 
+/// Large message with unsorted tags (1000..1000+N-1 permuted), compile time regression
+template <typename>
+struct synthetic_msg;
+
+template <size_t... I>
+struct synthetic_msg<std::index_sequence<I...>> {
+    enum : int { size = sizeof...(I) };
+    using type = preFIX::dict::msg_t<
+        preFIX::dict::field_base<int(I*97 % sizeof...(I)) + 1000, preFIX::types::Int>...>;
+};
+
+/// Layout test fields: hot ones are declared last but stored first
+namespace layout_test {
+    using Note      = preFIX::dict::field_base<9001, preFIX::types::String>;
+    using Venue     = preFIX::dict::field_base<9002, preFIX::types::String>;
+    using Qty       = preFIX::dict::field_base<9003, preFIX::types::Float>;
+    using Flag      = preFIX::dict::field_base<9004, preFIX::types::Char>;
+    
+    using Order = preFIX::dict::msg_t<Note, Venue, Qty, Flag>;
+}
+
+namespace preFIX { namespace dict {
+    template <> struct hot_field<layout_test::Qty>  : std::true_type {};
+    template <> struct hot_field<layout_test::Flag> : std::true_type {};
+}}
+
+namespace data_test {
+    using namespace preFIX::dict;
+    
+    using RawDataLength     = field_base<95,    preFIX::types::Int>;
+    using RawData           = field_base<96,    Data<RawDataLength>>;
+    using EncodedTextLen    = field_base<354,   preFIX::types::Int>;
+    using EncodedText       = field_base<355,   DataView<EncodedTextLen>>;
+    using Text              = field_base<58,    preFIX::types::String>;
+    using BlobLen           = field_base<9101,  preFIX::types::Int>;
+    using Blob              = field_base<9102,  Data<BlobLen>>;
+    using NoBlobs           = group_base<9100,  BlobLen, Blob, Text>;
+    
+    using Carrier = msg_t<RawDataLength, RawData, Text, EncodedTextLen, EncodedText, NoBlobs>;
+}
+
+/// Acceptor echoes messages back, initiator collects them
+struct loopback_handler {
+    preFIX::net::connection* initiator = nullptr;
+    std::vector<std::string> received;
+    int accepted = 0;
+    int echoed = 0;
+    int closed = 0;
+    
+    void on_connect(preFIX::net::connection& c) {
+        accepted += (&c != initiator); }
+    
+    void on_message(preFIX::net::connection& c, preFIX::read_cursor& msg) {
+        if(&c == initiator) {
+            received.emplace_back(msg.pointer(), msg.left());
+        } else {
+            c.send_raw(msg.pointer(), msg.left());
+            ++echoed;
+        }
+    }
+    
+    void on_close(preFIX::net::connection&) {
+        ++closed; }
+};
+
+/// Visitor for generated fix44::dispatch()
+struct msg_type_visitor {
+    std::string type;
+    
+    template <typename Msg>
+    void on() {
+        type = Msg::msg_type(); }
+};
+
 int main() {
     using namespace preFIX;
     using namespace preFIX::types;
@@ -127,15 +223,34 @@ int main() {
         LIGHT_TEST(serialize_message(wc.reset(), header, nos, trailer));
         stdcout(replace_SOH(buf));
         
-        /// Perf
-        if(1) {
-            const size_t N = 16_KIB;
-            size_t t = rdtsc();
-            for(size_t i = 0; i < N; ++i)
-                serialize_message(wc.reset(), header, nos, trailer);
-            t = rdtsc() - t;
-            stdprintf("=== Encoding NOS: %% ticks/msg, %% ticks/B",
-                double(t)/N, double(t)/(N*wc.processed()));
+        {
+            std::string msg(buf, wc.processed());
+            LIGHT_TEST(frame_message(read_cursor(msg.data(), msg.size())) == int(msg.size()));
+            LIGHT_TEST(validate_message(read_cursor(msg.data(), msg.size())));
+            
+            // Incomplete data
+            for(size_t size : {size_t(0), size_t(1), size_t(5), size_t(12), msg.size() - 1})
+                LIGHT_TEST(frame_message(read_cursor(msg.data(), size)) == 0);
+            
+            // Two messages in a row
+            std::string two = msg + msg;
+            LIGHT_TEST(frame_message(read_cursor(two.data(), two.size())) == int(msg.size()));
+            LIGHT_TEST(!validate_message(read_cursor(two.data(), two.size())));
+            
+            // Broken CheckSum, Length, BeginString
+            std::string bad = msg;
+            bad[bad.size() - 2] ^= 1;
+            LIGHT_TEST(!validate_message(read_cursor(bad.data(), bad.size())));
+            bad = msg;
+            bad[msg.find("\x01" "9=") + 3] = '1';
+            LIGHT_TEST(frame_message(read_cursor(bad.data(), bad.size())) != int(msg.size()));
+            bad = "X" + msg;
+            LIGHT_TEST(frame_message(read_cursor(bad.data(), bad.size())) == -1);
+            
+            // Empty BodyLength isn't taken for 0
+            bad = "8=FIX.4.4\x01" "9=\x01" "10=152\x01";
+            LIGHT_TEST(frame_message(read_cursor(bad.data(), bad.size())) == -1);
+            LIGHT_TEST(!validate_message(read_cursor(bad.data(), bad.size())));
         }
         
         {
@@ -151,19 +266,12 @@ int main() {
             stdcout(replace_SOH(buf), "<---- des");
         }
         
-        /// Perf
-        if(1) {
+        {
             clrbuf();
             nos.serialize(wc.reset());
             
             NewOrderSingle n2;
-            const size_t N = 16_KIB;
-            auto t = rdtsc();
-            for(size_t i = 0; i < N; ++i)
-                n2.deserialize(rc.reset(wc.processed()));
-            t = rdtsc() - t;
-            stdprintf("=== Decoding NOS: %% ticks/msg, %% ticks/B",
-                double(t)/N, double(t)/(N*rc.processed()));
+            LIGHT_TEST(n2.deserialize(rc.reset(wc.processed())));
             LIGHT_TEST(wc.processed() == rc.processed());
         }
     }
@@ -207,20 +315,41 @@ int main() {
             stdcout(replace_SOH(buf), "<---- des");
         }
         
-        /// Perf
-        if(1) {
-            NestedGroupsOrder n2;
-            const size_t N = 16_KIB;
-            auto t = rdtsc();
-            for(size_t i = 0; i < N; ++i)
-                n2.deserialize(rc.reset(wc.processed()));
-            t = rdtsc() - t;
-            stdprintf("=== Decoding NESTED: %% ticks/msg, %% ticks/B",
-                double(t)/N, double(t)/(N*rc.processed()));
-            LIGHT_TEST(wc.processed() == rc.processed());
-        }
     }
     
+#ifdef PREFIX_INSTRUMENT
+    {
+        using namespace test_dict;
+        
+        stats::registry::instance().reset();
+        stats::set_name<NewOrderSingle>("NewOrderSingle");
+        
+        NewOrderSingle nos;
+        nos.set<ClOrdID>("STATS").set<Side>('1');
+        nos.at<NoPartyID>().resize(2);
+        nos.at<NoPartyID>()[0].set<PartyID>("USER");
+        nos.at<NoPartyID>()[1].set<PartyID>("FIRM");
+        
+        LIGHT_TEST(nos.serialize(wc.reset()));
+        
+        NewOrderSingle n2;
+        LIGHT_TEST(n2.deserialize(rc.reset(wc.processed())));
+        
+        auto const& msg = stats::of<NewOrderSingle>().data;
+        LIGHT_TEST(msg.serialize_calls == 1 && msg.deserialize_calls == 1);
+        LIGHT_TEST(int(msg.bytes_out) == wc.processed() && int(msg.bytes_in) == rc.processed());
+        LIGHT_TEST(msg.serialize_cycles > 0);
+        
+        // Group ends with tag 54 which is unknown to group's entry
+        auto const& entry = stats::of<NoPartyID::type::group_element_type>().data;
+        LIGHT_TEST(entry.deserialize_calls == 2 && entry.unknown_tags == 1);
+        LIGHT_TEST(stats::of<NoPartyID::type>().data.allocations == 2);
+        
+        LIGHT_TEST(stats::registry::instance().find("NewOrderSingle") != nullptr);
+        stdcout(stats::registry::instance().report());
+    }
+#endif
+    
     {
         using namespace dict;
         using namespace preFIX::details;
@@ -264,6 +393,1405 @@ int main() {
         }
     }
     
+    {
+        using synthetic = synthetic_msg<std::make_index_sequence<256>>;
+        using msg_type = synthetic::type;
+        using seq = preFIX::details::index_map<1002, 1000, 1001>::sorted_seq;
+        static_assert(std::is_same<seq, preFIX::details::int_seq<1000, 1001, 1002>>::value, "");
+        
+        msg_type m;
+        long n = 0;
+        m.for_each([&n](fix_value_base& f) { static_cast<Int&>(f).value = n++; });
+        
+        std::vector<char> big(64_KIB);
+        write_cursor bwc(big.data(), big.size());
+        LIGHT_TEST(m.serialize(bwc));
+        
+        msg_type m2;
+        read_cursor brc(big.data(), bwc.processed());
+        LIGHT_TEST(m2.deserialize(brc) && brc.left() == 0);
+        
+        n = 0;
+        bool same = true;
+        m2.for_each([&](fix_value_base& f) { same &= (static_cast<Int&>(f).value == n++); });
+        LIGHT_TEST(same && n == synthetic::size);
+    }
+    
+    {
+        using namespace test_dict;
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP");
+        
+        NewOrderSingle nos;
+        nos.set<Account>("ololo//OLOLO").set<Side>('2');
+        nos.at<NoPartyID>().resize(1);
+        nos.at<NoPartyID>()[0].set<PartyID>("USER").set<PartyRole>(12);
+        
+        Trailer trailer;
+        
+        msg_template<Header, NewOrderSingle,
+            MsgSeqNum, SendingTime, ClOrdID, Price> tpl;
+        
+        LIGHT_TEST(!tpl.serialize(wc.reset(), header, nos));
+        LIGHT_TEST(tpl.build(header, nos));
+        
+        char ref[1_KIB];
+        write_cursor rwc(ref, sizeof(ref));
+        
+        for(int seq = 1; seq <= 100; ++seq) {
+            header.set<MsgSeqNum>(seq * 37)
+                  .set<SendingTime>(1492509600000 + seq);
+            nos.set<ClOrdID>("ORD" + std::to_string(seq * seq))
+               .set<Price>(seq * 0.25);
+            if(seq == 50)
+                nos.clear<Price>(); // omitted variable field
+            
+            clrbuf();
+            LIGHT_TEST(tpl.serialize(wc.reset(), header, nos));
+            LIGHT_TEST(serialize_message(rwc.reset(), header, nos, trailer));
+            LIGHT_TEST(std::string(buf, wc.processed()) == std::string(ref, rwc.processed()));
+        }
+        stdcout(replace_SOH(buf), "<---- tpl");
+        
+        // Variable field before Length would move it
+        msg_template<Header, NewOrderSingle, BeginString, MsgSeqNum> early;
+        LIGHT_TEST(!early.build(header, nos));
+        
+        // Body longer than Length digits allow
+        std::vector<char> big(256_KIB);
+        write_cursor bwc(big.data(), int(big.size()));
+        nos.set<ClOrdID>(std::string(100000, 'x'));
+        LIGHT_TEST(!tpl.serialize(bwc, header, nos));
+    }
+    
+    {
+        using namespace fix44;
+        
+        Header header;
+        header.set<BeginString> (begin_string)
+              .set<MsgType>     (NewOrderSingle::msg_type())
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP")
+              .set<MsgSeqNum>   (7)
+              .set<SendingTime> (1492509600123);
+        
+        NewOrderSingle nos;
+        nos.set<ClOrdID>("ORD1")
+           .set<Symbol>("EURUSD")
+           .set<Side>(Side_values::SELL)
+           .set<OrdType>(OrdType_values::LIMIT)
+           .set<Price>(1.25)
+           .set<OrderQty>(100);
+        nos.at<NoPartyIDs>().resize(1);
+        nos.at<NoPartyIDs>()[0].set<PartyID>("USER").set<PartyRole>(PartyRole_values::CLIENT_ID);
+        nos.at<NoPartyIDs>()[0].at<NoPartySubIDs>().resize(2);
+        nos.at<NoPartyIDs>()[0].at<NoPartySubIDs>()[0].set<PartySubID>("DESK1").set<PartySubIDType>(9);
+        nos.at<NoPartyIDs>()[0].at<NoPartySubIDs>()[1].set<PartySubID>("DESK2");
+        nos.at<NoSecurityAltID>().resize(1);
+        nos.at<NoSecurityAltID>()[0].set<SecurityAltID>("EUR/USD").set<SecurityAltIDSource>("8");
+        
+        Trailer trailer;
+        
+        clrbuf();
+        LIGHT_TEST(serialize_message(wc.reset(), header, nos, trailer));
+        LIGHT_TEST(validate_message(read_cursor(buf, wc.processed())));
+        stdcout(replace_SOH(buf), "<---- gen");
+        
+        std::string msg(buf, wc.processed());
+        
+        Header h2;
+        NewOrderSingle n2;
+        Trailer t2;
+        rc.reset(wc.processed());
+        LIGHT_TEST(h2.deserialize(rc) && n2.deserialize(rc) && t2.deserialize(rc));
+        LIGHT_TEST(rc.processed() == int(msg.size()));
+        LIGHT_TEST(n2.at<NoPartyIDs>()[0].at<NoPartySubIDs>().value.size() == 2);
+        LIGHT_TEST(n2.at<Side>().value == Side_values::SELL && n2.at<Price>().value == 1.25);
+        
+        clrbuf();
+        LIGHT_TEST(serialize_message(wc.reset(), h2, n2, t2));
+        LIGHT_TEST(std::string(buf, wc.processed()) == msg);
+        
+        // MsgType dispatching
+        msg_type_visitor v;
+        for(auto type : {"0", "1", "A", "D", "S"})
+            LIGHT_TEST(dispatch(type, v) && v.type == type);
+        for(auto type : {"", "B", "AA", "Z"})
+            LIGHT_TEST(!dispatch(type, v));
+        
+        // Binary codec over generated (derived from msg_t) messages
+        char bin[1_KIB];
+        write_cursor bwc(bin, sizeof(bin));
+        LIGHT_TEST(sbe::serialize_binary_message(bwc, header, nos));
+        
+        Header h3;
+        NewOrderSingle n3;
+        read_cursor brc(bin, bwc.processed());
+        LIGHT_TEST(sbe::deserialize_binary_message(brc, h3, n3) && brc.left() == 0);
+        LIGHT_TEST(n3.at<NoPartyIDs>()[0].at<NoPartySubIDs>()[1].at<PartySubID>().value == "DESK2");
+        
+        clrbuf();
+        LIGHT_TEST(serialize_message(wc.reset(), h3, n3, t2));
+        LIGHT_TEST(std::string(buf, wc.processed()) == msg);
+        
+        // Layout report of generated message
+        using nos_info = layout_info<NewOrderSingle>;
+        static_assert(nos_info::size == sizeof(NewOrderSingle), "");
+        LIGHT_TEST(nos_info::describe().find("tag 44") != std::string::npos);
+        
+        LIGHT_TEST(std::string(begin_string) == "FIX.4.4");
+        
+        // DATA field is generated as Data<> bound to its LENGTH field
+        Logon logon;
+        std::string secret("\x01" "98=1\x01" "key", 9);
+        logon.set<EncryptMethod>(0).set<HeartBtInt>(30).set<RawData>(secret);
+        LIGHT_TEST(logon.at<RawDataLength>().value == 9);
+        header.set<MsgType>(Logon::msg_type());
+        LIGHT_TEST(serialize_message(wc.reset(), header, logon, trailer));
+        
+        Logon l2;
+        rc.reset(wc.processed());
+        LIGHT_TEST(h2.deserialize(rc) && l2.deserialize(rc) && t2.deserialize(rc));
+        LIGHT_TEST(l2.at<RawData>().value == secret && l2.at<HeartBtInt>().value == 30);
+    }
+    
+    {
+        using namespace test_dict;
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP");
+        
+        NewOrderSingle nos;
+        nos.set<Account>("ololo//OLOLO").set<Side>('2').set<Price>(1.5);
+        nos.at<NoPartyID>().resize(3);
+        for(int i = 0; i < 3; ++i)
+            nos.at<NoPartyID>()[i].set<PartyID>("USER" + std::to_string(i)).set<PartyRole>(i);
+        
+        Trailer trailer;
+        
+        // Small blocks => every message spans several segments
+        block_pool pool(48);
+        segmented_cursor sc(pool);
+        
+        std::string expected;
+        for(int seq = 1; seq <= 20; ++seq) {
+            header.set<MsgSeqNum>(seq);
+            nos.set<ClOrdID>("ORD" + std::to_string(seq * 7919));
+            
+            LIGHT_TEST(serialize_message(wc.reset(), header, nos, trailer));
+            expected.append(buf, wc.processed());
+            
+            LIGHT_TEST(serialize_message(sc, header, nos, trailer));
+            LIGHT_TEST(sc.size() == int(expected.size()));
+        }
+        LIGHT_TEST(sc.segments() > 20);
+        
+        std::vector<iovec> iov(sc.segments());
+        int count = sc.to_iovec(iov.data(), int(iov.size()));
+        std::string gathered;
+        for(int i = 0; i < count; ++i)
+            gathered.append(static_cast<char const*>(iov[i].iov_base), iov[i].iov_len);
+        LIGHT_TEST(gathered == expected);
+        
+        // Value larger than block is rejected, cursor is rolled back
+        nos.set<Account>(std::string(100, 'A'));
+        LIGHT_TEST(!serialize_message(sc, header, nos, trailer));
+        LIGHT_TEST(sc.size() == int(expected.size()));
+        
+        // Partial consuming + writev
+        int fds[2];
+        LIGHT_TEST(::pipe(fds) == 0);
+        sc.consume(10);
+        LIGHT_TEST(sc.size() == int(expected.size()) - 10);
+        
+        std::string received;
+        while(sc.size() > 0) {
+            LIGHT_TEST(sc.flush(fds[1]) > 0);
+            char tmp[4096];
+            ssize_t n = ::read(fds[0], tmp, sizeof(tmp));
+            LIGHT_TEST(n > 0);
+            received.append(tmp, n);
+        }
+        LIGHT_TEST(received == expected.substr(10));
+        ::close(fds[0]);
+        ::close(fds[1]);
+        
+        sc.reset();
+        LIGHT_TEST(pool.available() == pool.allocated());
+        
+        // Raw bytes are split between blocks
+        std::string raw(200, 'x');
+        sc.append(raw.data(), int(raw.size()));
+        LIGHT_TEST(sc.size() == 200 && sc.segments() == 5);
+        sc.truncate(60);
+        LIGHT_TEST(sc.size() == 60 && sc.segments() == 2);
+    }
+    
+    {
+        using namespace test_dict;
+        
+        // Mirrored ring: spans are contiguous across the wrap point
+        net::mirrored_ring ring;
+        LIGHT_TEST(ring.open(4096) && ring.capacity() >= 4096);
+        size_t cap = ring.capacity();
+        ring.produce(cap - 100);
+        ring.consume(cap - 100);
+        std::string chunk(300, 'z');
+        chunk[0] = 'a';
+        chunk[299] = 'b';
+        LIGHT_TEST(ring.writable() == cap);
+        std::memcpy(ring.write_ptr(), chunk.data(), chunk.size());
+        ring.produce(chunk.size());
+        LIGHT_TEST(std::string(ring.read_ptr(), ring.readable()) == chunk);
+        
+        // Loopback: initiator => acceptor (echo) => initiator
+        loopback_handler handler;
+        net::options opt;
+        opt.ring_size = 4096;
+        net::reactor<loopback_handler> r(handler, opt);
+        LIGHT_TEST(r.ok());
+        
+        int lfd = r.listen("127.0.0.1", 0);
+        LIGHT_TEST(lfd >= 0);
+        auto port = net::reactor<loopback_handler>::local_port(lfd);
+        
+        handler.initiator = r.connect("127.0.0.1", port);
+        LIGHT_TEST(handler.initiator);
+        for(int i = 0; i < 1000 && !(handler.initiator->connected() && handler.accepted == 1); ++i)
+            r.poll(10);
+        LIGHT_TEST(handler.initiator->connected() && handler.accepted == 1);
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP");
+        NewOrderSingle nos;
+        nos.set<Account>("ACC").set<Side>('1');
+        Trailer trailer;
+        
+        // Total size is much larger than receive ring => ring wraps many times
+        std::vector<std::string> sent;
+        for(int seq = 1; seq <= 200; ++seq) {
+            header.set<MsgSeqNum>(seq);
+            nos.set<ClOrdID>("ORD" + std::to_string(seq));
+            LIGHT_TEST(handler.initiator->send(header, nos, trailer));
+            LIGHT_TEST(serialize_message(wc.reset(), header, nos, trailer));
+            sent.emplace_back(buf, wc.processed());
+        }
+        for(int i = 0; i < 1000 && handler.received.size() < sent.size(); ++i)
+            r.poll(10);
+        LIGHT_TEST(handler.received == sent && handler.echoed == 200);
+        
+        // Byte-by-byte delivery from plain blocking socket
+        int raw = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        LIGHT_TEST(::connect(raw, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        
+        std::string two = sent[0] + sent[1];
+        for(char ch : two) {
+            LIGHT_TEST(::send(raw, &ch, 1, 0) == 1);
+            r.poll(0);
+        }
+        for(int i = 0; i < 1000 && handler.echoed < 202; ++i)
+            r.poll(10);
+        LIGHT_TEST(handler.echoed == 202);
+        
+        std::string echoed;
+        while(echoed.size() < two.size()) {
+            char tmp[512];
+            ssize_t n = ::recv(raw, tmp, sizeof(tmp), 0);
+            LIGHT_TEST(n > 0);
+            echoed.append(tmp, n);
+        }
+        LIGHT_TEST(echoed == two);
+        
+        // Malformed data closes connection
+        LIGHT_TEST(::send(raw, "garbage=1\x01", 10, 0) == 10);
+        for(int i = 0; i < 1000 && handler.closed == 0; ++i)
+            r.poll(10);
+        LIGHT_TEST(handler.closed == 1 && r.connections() == 3);
+        ::close(raw);
+    }
+    
+    {
+        using namespace test_dict;
+        
+        std::string path = "/dev/shm/preFIX_test_" + std::to_string(::getpid());
+        ipc::shm_ring ring;
+        LIGHT_TEST(ring.create(path, 256, 6) && ring.slot_count() == 8);
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<TargetCompID>("THEIRTCOMP");
+        NewOrderSingle nos;
+        nos.set<Account>("ACC").set<Side>('1');
+        Trailer trailer;
+        
+        auto make = [&](int producer, int seq) {
+            header.set<SenderCompID>("P" + std::to_string(producer)).set<MsgSeqNum>(seq);
+            nos.set<ClOrdID>("ORD" + std::to_string(seq));
+        };
+        
+        // Full ring and oversized message (cancelled slot is skipped by reader)
+        make(0, 1);
+        for(int i = 0; i < 8; ++i)
+            LIGHT_TEST(ring.send(header, nos, trailer));
+        LIGHT_TEST(!ring.try_reserve() && !ring.send(header, nos, trailer));
+        LIGHT_TEST(ring.poll([](read_cursor&) {}, 1) == 1);
+        nos.set<ClOrdID>(std::string(300, 'x'));
+        LIGHT_TEST(!ring.send(header, nos, trailer));
+        LIGHT_TEST(ring.poll([](read_cursor& msg) {
+            LIGHT_TEST(validate_message(msg)); }) == 7);
+        LIGHT_TEST(!ring.ready() && !ring.wait(1000, 10));
+        
+        // Two producer processes attach by path, per-producer order is kept
+        enum : int { producers = 2, count = 500 };
+        std::vector<pid_t> children;
+        for(int p = 0; p < producers; ++p) {
+            pid_t pid = ::fork();
+            if(pid == 0) {
+                ipc::shm_ring writer;
+                if(!writer.open(path))
+                    ::_exit(1);
+                for(int seq = 1; seq <= count; ++seq) {
+                    make(p, seq);
+                    auto slot = writer.reserve();
+                    if(!serialize_message(slot.cursor, header, nos, trailer))
+                        ::_exit(2);
+                    writer.commit(slot);
+                }
+                ::_exit(0);
+            }
+            LIGHT_TEST(pid > 0);
+            children.push_back(pid);
+        }
+        
+        std::vector<std::vector<std::string>> received(producers);
+        size_t total = 0;
+        while(total < producers*count && ring.wait(5000000)) {
+            total += ring.poll([&](read_cursor& msg) {
+                LIGHT_TEST(validate_message(msg));
+                std::string text(msg.pointer(), msg.left());
+                received[text.find("\x01" "49=P1\x01") != std::string::npos].push_back(text);
+            });
+        }
+        
+        for(pid_t pid : children) {
+            int status = -1;
+            LIGHT_TEST(::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+        
+        char out[512];
+        write_cursor owc(out, sizeof(out));
+        for(int p = 0; p < producers; ++p) {
+            LIGHT_TEST(received[p].size() == count);
+            for(int seq = 1; seq <= count && seq <= int(received[p].size()); ++seq) {
+                make(p, seq);
+                LIGHT_TEST(serialize_message(owc.reset(), header, nos, trailer));
+                LIGHT_TEST(received[p][seq - 1] == std::string(out, owc.processed()));
+            }
+        }
+        
+        ring.close();
+        ::unlink(path.c_str());
+    }
+    
+    {
+        using namespace layout_test;
+        using info = dict::layout_info<Order>;
+        
+        static_assert(info::fields_size == 2*sizeof(Note) + sizeof(Qty) + sizeof(Flag), "");
+        static_assert(info::size == info::fields_size + info::padding, "");
+        stdcout(info::describe());
+        
+        // Hot fields are stored first, in declaration order
+        Order order;
+        char const* base = reinterpret_cast<char const*>(&order);
+        LIGHT_TEST(reinterpret_cast<char const*>(&order.at<Qty>()) == base);
+        LIGHT_TEST(reinterpret_cast<char const*>(&order.at<Flag>()) == base + sizeof(Qty));
+        LIGHT_TEST(reinterpret_cast<char const*>(&order.at<Note>()) > reinterpret_cast<char const*>(&order.at<Flag>()));
+        
+        // Serialization still follows declaration order
+        order.set<Note>("n").set<Venue>("XLON").set<Qty>(5).set<Flag>('Y');
+        char out[256];
+        write_cursor owc(out, sizeof(out));
+        LIGHT_TEST(order.serialize(owc));
+        LIGHT_TEST(replace_SOH(std::string(out, owc.processed())) == "9001=n|9002=XLON|9003=5.000000|9004=Y|");
+        
+        Order parsed;
+        read_cursor orc(out, owc.processed());
+        LIGHT_TEST(parsed.deserialize(orc) && parsed.at<Venue>().value == "XLON" && parsed.at<Flag>().value == 'Y');
+    }
+    
+    {
+        using namespace test_dict;
+        
+        static_assert(sbe::block_length<NewOrderSingle>() == 8 + 1, "Price + Side");
+        static_assert(sbe::block_length<Trailer>() == 8, "CheckSum");
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("8")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP")
+              .set<MsgSeqNum>   (42)
+              .set<SendingTime> (1492509600123);
+        ExecutionReport exec;
+        exec.set<OrderID>("EX-1").set<ClOrdID>("ORD-1").set<ExecType>('F').set<Side>('2')
+            .set<OrderQty>(1000).set<LastPx>(1.0835).set<TransactTime>(1492509600123456);
+        exec.at<NoPartyID>().resize(2);
+        exec.at<NoPartyID>()[0].set<PartyID>("USER").set<PartyIDSource>('D').set<PartyRole>(12);
+        exec.at<NoPartyID>()[1].set<PartyID>("FIRM").set<PartyRole>(1);
+        Trailer trailer;
+        
+        char fix[1_KIB], bin[1_KIB], back[1_KIB];
+        write_cursor fwc(fix, sizeof(fix));
+        LIGHT_TEST(serialize_message(fwc, header, exec, trailer));
+        
+        // tag=value => binary => tag=value gives the same bytes
+        Header h2;
+        ExecutionReport e2;
+        Trailer t2;
+        read_cursor frc(fix, fwc.processed());
+        write_cursor bwc(bin, sizeof(bin));
+        LIGHT_TEST(sbe::fix_to_binary(frc, bwc, h2, e2, t2) && frc.left() == 0);
+        LIGHT_TEST(bwc.processed() < fwc.processed());
+        LIGHT_TEST(sbe::frame_binary(read_cursor(bin, bwc.processed())) == bwc.processed());
+        
+        Header h3;
+        ExecutionReport e3;
+        Trailer t3;
+        h3.set<PossDupFlag>('Y');     // overwritten by decoding
+        read_cursor brc(bin, bwc.processed());
+        write_cursor back_wc(back, sizeof(back));
+        LIGHT_TEST(sbe::binary_to_fix(brc, back_wc, h3, e3, t3) && brc.left() == 0);
+        LIGHT_TEST(std::string(fix, fwc.processed()) == std::string(back, back_wc.processed()));
+        LIGHT_TEST(!h3.at<PossDupFlag>().present() && !e3.at<Price>().present());
+        LIGHT_TEST(e3.at<NoPartyID>()[1].at<PartyID>().value == "FIRM" && e3.at<LastPx>().value == 1.0835);
+        
+        // Truncated, malformed and too small output
+        for(int size = 0; size < bwc.processed(); ++size) {
+            read_cursor part(bin, size);
+            LIGHT_TEST(sbe::frame_binary(part) == 0 && !sbe::deserialize_binary_message(part, h3, e3));
+        }
+        std::string bad(bin, bwc.processed());
+        bad[4] = 0;
+        LIGHT_TEST(sbe::frame_binary(read_cursor(bad.data(), bad.size())) == -1);
+        for(int size = 0; size < bwc.processed(); ++size) {
+            write_cursor small(back, size);
+            LIGHT_TEST(!sbe::serialize_binary_message(small, header, exec));
+        }
+        
+        // Entries with larger blockLength (newer schema) are decoded, extra bytes skipped
+        NewOrderSingle nos;
+        nos.set<ClOrdID>("ORD-2").set<Price>(1.5);
+        nos.at<NoPartyID>().resize(1);
+        nos.at<NoPartyID>()[0].set<PartyID>("P").set<PartyRole>(7);
+        write_cursor nwc(bin, sizeof(bin));
+        LIGHT_TEST(sbe::serialize_binary(nwc, nos));
+        std::string wide(bin, 9);                       // root block
+        wide += std::string("\x0B\x00\x01\x00", 4);   // blockLength 9 => 11
+        wide += std::string(bin + 13, 9) + "xx";        // entry block + extension
+        wide += std::string(bin + 22, nwc.processed() - 22);
+        NewOrderSingle n2;
+        read_cursor wrc(wide.data(), wide.size());
+        LIGHT_TEST(sbe::deserialize_binary(wrc, n2) && wrc.left() == 0);
+        LIGHT_TEST(n2.at<NoPartyID>()[0].at<PartyRole>().value == 7 && n2.at<NoPartyID>()[0].at<PartyID>().value == "P");
+        LIGHT_TEST(n2.at<ClOrdID>().value == "ORD-2" && n2.at<Price>().value == 1.5);
+    }
+    
+    {
+        using namespace test_dict;
+        
+        using CachedNOS = cached_msg_t<ClOrdID, Account, NoPartyID, Price, Side>;
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP")
+              .set<MsgSeqNum>   (1);
+        
+        CachedNOS cached;
+        NewOrderSingle plain;
+        Trailer trailer;
+        
+        auto both = [&](std::function<void(CachedNOS&)> fc, std::function<void(NewOrderSingle&)> fp) {
+            fc(cached);
+            fp(plain);
+            
+            char ref[1_KIB];
+            write_cursor rwc(ref, sizeof(ref));
+            
+            clrbuf();
+            LIGHT_TEST(serialize_message(wc.reset(), header, cached, trailer));
+            LIGHT_TEST(serialize_message(rwc, header, plain, trailer));
+            LIGHT_TEST(std::string(buf, wc.processed()) == std::string(ref, rwc.processed()));
+        };
+        
+        both([](CachedNOS& m) {
+            m.set<ClOrdID>("Q1").set<Account>("ACC").set<Price>(10.5).set<Side>('1');
+            m.modify<NoPartyID>([](NoPartyID& parties) {
+                parties.resize(2);
+                parties[0].set<PartyID>("USER");
+            });
+        }, [](NewOrderSingle& m) {
+            m.set<ClOrdID>("Q1").set<Account>("ACC").set<Price>(10.5).set<Side>('1');
+            m.at<NoPartyID>().resize(2);
+            m.at<NoPartyID>()[0].set<PartyID>("USER");
+        });
+        LIGHT_TEST(cached.reencoded() == 5);
+        
+        // Same width
+        both([](CachedNOS& m) { m.set<Side>('2'); },
+             [](NewOrderSingle& m) { m.set<Side>('2'); });
+        LIGHT_TEST(cached.reencoded() == 6);
+        
+        // Growing, shrinking, omitting
+        both([](CachedNOS& m) { m.set<ClOrdID>("QUOTE-0000001"); },
+             [](NewOrderSingle& m) { m.set<ClOrdID>("QUOTE-0000001"); });
+        both([](CachedNOS& m) { m.set<Account>("A"); m.clear<Price>(); },
+             [](NewOrderSingle& m) { m.set<Account>("A"); m.clear<Price>(); });
+        both([](CachedNOS& m) { m.modify<NoPartyID>([](NoPartyID& p) { p[1].set<PartyRole>(3); }); },
+             [](NewOrderSingle& m) { m.at<NoPartyID>()[1].set<PartyRole>(3); });
+        LIGHT_TEST(cached.reencoded() == 10);
+        
+        // Untouched => nothing to re-encode
+        both([](CachedNOS&) {}, [](NewOrderSingle&) {});
+        LIGHT_TEST(cached.reencoded() == 10);
+        stdcout(replace_SOH(buf), "<---- cached");
+        
+        // Fields can't be changed behind the cache
+        static_assert(!std::is_convertible<CachedNOS&, NewOrderSingle&>::value, "msg_t base is hidden");
+        static_assert(std::is_const<std::remove_reference_t<decltype(cached.at<Price>())>>::value, "read-only at<>()");
+        
+    }
+    
+    {
+        using namespace test_dict;
+        
+        const char* path = "preFIX_test.journal";
+        std::remove(path);
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP")
+              .set<PossDupFlag> ('N')
+              .set<SendingTime> (1492509600000)  // 20170418-10:00:00.000
+              .set<OrigSendingTime>(0);
+        
+        NewOrderSingle nos;
+        nos.set<ClOrdID>("JRNL").set<Price>(1.5).set<Side>('1');
+        Trailer trailer;
+        
+        std::vector<std::string> sent(6);
+        {
+            journal j;
+            LIGHT_TEST(j.open(path, 4096, 64, 1024));
+            
+            // 1 segment = 4096 B, forces several rolls
+            for(int seq = 1; seq <= 5; ++seq) {
+                header.set<MsgSeqNum>(seq);
+                auto wc = j.reserve();
+                LIGHT_TEST(serialize_message(wc, header, nos, trailer));
+                LIGHT_TEST(j.commit(seq, wc));
+                sent[seq].assign(wc.pointer() - wc.processed(), wc.processed());
+                
+                for(int k = 0; k < 3; ++k) {
+                    auto pad = j.reserve();
+                    LIGHT_TEST(serialize_message(pad, header, nos, trailer));
+                    LIGHT_TEST(j.commit(63, pad));
+                }
+                LIGHT_TEST(j.prepare());    // spare for the next roll
+            }
+            LIGHT_TEST(j.inline_rolls() == 0);
+        }
+        
+        // Stored geometry wins: 4096 B segments limit max_message
+        journal j;
+        LIGHT_TEST(!j.open(path, 1 << 20, 1 << 10, 8192));
+        LIGHT_TEST(j.open(path, 1 << 20, 1 << 10, 1024));
+        LIGHT_TEST(j.capacity() == 64 && j.last_seq() == 63);
+        
+        int visited = j.range(2, 4, [&](int seq, read_cursor rc) {
+            LIGHT_TEST(std::string(rc.pointer(), rc.left()) == sent[seq]);
+        });
+        LIGHT_TEST(visited == 3);
+        LIGHT_TEST(j.range(1, 0, [](int, read_cursor){}) == 6);
+        LIGHT_TEST(j.get(6).left() == 0);
+        
+        // Appending after reopening keeps old messages intact
+        header.set<MsgSeqNum>(6);
+        auto wc = j.reserve();
+        LIGHT_TEST(serialize_message(wc, header, nos, trailer));
+        LIGHT_TEST(j.commit(6, wc));
+        LIGHT_TEST(std::string(j.get(5).pointer(), j.get(5).left()) == sent[5]);
+        
+        // Resend preparation, compared with regular encoding
+        LIGHT_TEST(rewrite_poss_dup(j.get_mutable(3), "20170418-10:05:00.000"));
+        
+        header.set<MsgSeqNum>(3)
+              .set<PossDupFlag>('Y')
+              .set<SendingTime>(1492509900000)
+              .set<OrigSendingTime>(1492509600000);
+        char ref[1_KIB];
+        write_cursor rwc(ref, sizeof(ref));
+        LIGHT_TEST(serialize_message(rwc, header, nos, trailer));
+        LIGHT_TEST(std::string(j.get(3).pointer(), j.get(3).left()) == std::string(ref, rwc.processed()));
+        stdcout(replace_SOH(std::string(j.get(3).pointer(), j.get(3).left())), "<---- resend");
+        
+        // Tags inside Data payload aren't taken for header/trailer fields
+        data_test::Carrier carrier;
+        carrier.set<data_test::RawData>(std::string("\x01" "43=N\x01" "52=X\x01" "122=20170418-10:00:00.000\x01" "10=123\x01"));
+        header.set<MsgSeqNum>(8)
+              .set<PossDupFlag>('N')
+              .set<SendingTime>(1492509600000)
+              .set<OrigSendingTime>(0);
+        wc = j.reserve();
+        LIGHT_TEST(serialize_message(wc, header, carrier, trailer));
+        LIGHT_TEST(j.commit(8, wc));
+        LIGHT_TEST(rewrite_poss_dup(j.get_mutable(8), "20170418-10:05:00.000"));
+        
+        header.set<PossDupFlag>('Y')
+              .set<SendingTime>(1492509900000)
+              .set<OrigSendingTime>(1492509600000);
+        LIGHT_TEST(serialize_message(rwc.reset(), header, carrier, trailer));
+        LIGHT_TEST(std::string(j.get(8).pointer(), j.get(8).left()) == std::string(ref, rwc.processed()));
+        
+        // No reserved slots => header is re-encoded into a copy
+        header.set<MsgSeqNum>(7).set<SendingTime>(1492509600000);
+        header.clear<PossDupFlag>();
+        header.clear<OrigSendingTime>();
+        wc = j.reserve();
+        LIGHT_TEST(serialize_message(wc, header, carrier, trailer));
+        LIGHT_TEST(j.commit(7, wc));
+        LIGHT_TEST(!rewrite_poss_dup(j.get_mutable(7)));
+        
+        char copy[1_KIB];
+        write_cursor cwc(copy, sizeof(copy));
+        LIGHT_TEST(copy_poss_dup(j.get(7), cwc, "20170418-10:05:00.000"));
+        
+        header.set<PossDupFlag>('Y')
+              .set<SendingTime>(1492509900000)
+              .set<OrigSendingTime>(1492509600000);
+        LIGHT_TEST(serialize_message(rwc.reset(), header, carrier, trailer));
+        LIGHT_TEST(std::string(copy, cwc.processed()) == std::string(ref, rwc.processed()));
+        LIGHT_TEST(validate_message(read_cursor(copy, cwc.processed())));
+        
+        for(int size = 0; size < rwc.processed(); ++size) {
+            write_cursor small(copy, size);
+            LIGHT_TEST(!copy_poss_dup(j.get(7), small) && small.processed() == 0);
+        }
+        
+        // Body isn't parsed: Data payloads with SOH or header tags are copied as is
+        data_test::Carrier blobs;
+        blobs.at<data_test::NoBlobs>().resize(2);
+        blobs.at<data_test::NoBlobs>()[0].set<data_test::Blob>(std::string("a\x01" "b"));
+        blobs.at<data_test::NoBlobs>()[1].set<data_test::Blob>(std::string("\x01" "43=N\x01" "122=20170418-10:00:00.000"));
+        header.set<MsgSeqNum>(9).set<SendingTime>(1492509600000);
+        header.clear<PossDupFlag>();
+        header.clear<OrigSendingTime>();
+        wc = j.reserve();
+        LIGHT_TEST(serialize_message(wc, header, blobs, trailer));
+        LIGHT_TEST(j.commit(9, wc));
+        LIGHT_TEST(!rewrite_poss_dup(j.get_mutable(9)));
+        LIGHT_TEST(copy_poss_dup(j.get(9), cwc.reset(), "20170418-10:05:00.000"));
+        
+        header.set<PossDupFlag>('Y')
+              .set<SendingTime>(1492509900000)
+              .set<OrigSendingTime>(1492509600000);
+        LIGHT_TEST(serialize_message(rwc.reset(), header, blobs, trailer));
+        LIGHT_TEST(std::string(copy, cwc.processed()) == std::string(ref, rwc.processed()));
+        
+        // Without prepare() the second roll maps segment inline
+        for(int k = 0; k < 60; ++k) {
+            auto pad = j.reserve();
+            LIGHT_TEST(serialize_message(pad, header, nos, trailer));
+            LIGHT_TEST(j.commit(63, pad));
+        }
+        LIGHT_TEST(j.inline_rolls() > 0);
+        
+        // Sequence reset: old session isn't resent, space is reused from the start
+        char const* first = j.get(1).pointer();
+        LIGHT_TEST(j.reset(1) && j.last_seq() == -1);
+        LIGHT_TEST(j.range(1, 0, [](int, read_cursor) {}) == 0);
+        
+        std::vector<std::string> session(3);
+        for(int seq = 1; seq <= 2; ++seq) {
+            header.set<MsgSeqNum>(seq);
+            wc = j.reserve();
+            LIGHT_TEST(serialize_message(wc, header, nos, trailer));
+            LIGHT_TEST(j.commit(seq, wc));
+            session[seq].assign(wc.pointer() - wc.processed(), wc.processed());
+        }
+        LIGHT_TEST(j.get(1).pointer() == first && j.last_seq() == 2);
+        
+        visited = j.range(1, 0, [&](int seq, read_cursor rc) {
+            LIGHT_TEST(std::string(rc.pointer(), rc.left()) == session[seq]);
+        });
+        LIGHT_TEST(visited == 2);
+        
+        // Partial reset survives reopening
+        LIGHT_TEST(j.reset(2) && j.last_seq() == 1 && j.get(2).left() == 0);
+        j.close();
+        LIGHT_TEST(j.open(path, 4096, 64, 1024) && j.last_seq() == 1);
+        LIGHT_TEST(std::string(j.get(1).pointer(), j.get(1).left()) == session[1]);
+        
+        j.close();
+        std::remove(path);
+    }
+    
+    {
+        using namespace test_dict;
+        using namespace preFIX::md;
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<SenderCompID>("FEED")
+              .set<TargetCompID>("ME")
+              .set<MsgSeqNum>   (1);
+        Trailer trailer;
+        
+        book_set<4> books;
+        md_decoder<4> decoder(books);
+        
+        // Snapshot: 35=W
+        header.set<MsgType>("W");
+        MarketDataSnapshotFullRefresh snap;
+        snap.set<Symbol>("EURUSD");
+        std::array<std::array<double,3>,6> levels = {{
+            {{'0', 1.0835, 1e6}}, {{'0', 1.0836, 2e6}}, {{'0', 1.0833, 3e6}},
+            {{'1', 1.0838, 1e6}}, {{'1', 1.0840, 5e6}}, {{'1', 1.0839, 4e6}}
+        }};
+        snap.at<NoMDEntriesSnapshot>().resize(levels.size());
+        for(size_t i = 0; i < levels.size(); ++i)
+            snap.at<NoMDEntriesSnapshot>()[i]
+                .set<MDEntryType>(char(levels[i][0]))
+                .set<MDEntryPx>  (levels[i][1])
+                .set<MDEntrySize>(levels[i][2]);
+        
+        clrbuf();
+        LIGHT_TEST(serialize_message(wc.reset(), header, snap, trailer));
+        LIGHT_TEST(decoder.decode(rc.reset(wc.processed())));
+        LIGHT_TEST(rc.processed() == wc.processed());
+        
+        auto const& eur = *books.find("EURUSD");
+        LIGHT_TEST(eur.bids.size() == 3 && eur.asks.size() == 3);
+        LIGHT_TEST(eur.bids.best().price == 1.0836 && eur.bids[2].price == 1.0833);
+        LIGHT_TEST(eur.asks.best().price == 1.0838 && eur.asks[2].price == 1.0840);
+        
+        // Incremental: 35=X, symbol is inherited by following entries
+        header.set<MsgType>("X");
+        MarketDataIncrementalRefresh inc;
+        auto& entries = inc.at<NoMDEntries>().resize(6);
+        entries[0].set<MDUpdateAction>('0').set<MDEntryType>('0').set<Symbol>("EURUSD")
+                  .set<MDEntryPx>(1.0837).set<MDEntrySize>(7e5);   // new best bid
+        entries[1].set<MDUpdateAction>('2').set<MDEntryType>('1')
+                  .set<MDEntryPx>(1.0838);                          // best ask gone
+        entries[2].set<MDUpdateAction>('1').set<MDEntryType>('1')
+                  .set<MDEntryPx>(1.0839).set<MDEntrySize>(1e5);    // size change
+        entries[3].set<MDUpdateAction>('0').set<MDEntryType>('0').set<Symbol>("USDJPY")
+                  .set<MDEntryPx>(110.5).set<MDEntrySize>(1e6);
+        entries[4].set<MDUpdateAction>('0').set<MDEntryType>('2')
+                  .set<MDEntryPx>(110.6).set<MDEntrySize>(1e6);     // trade, ignored
+        entries[5].set<MDUpdateAction>('0').set<MDEntryType>('0')
+                  .set<MDEntryPx>(110.4).set<MDEntrySize>(2e6);
+        
+        clrbuf();
+        LIGHT_TEST(serialize_message(wc.reset(), header, inc, trailer));
+        stdcout(replace_SOH(buf), "<---- md");
+        LIGHT_TEST(decoder.decode(rc.reset(wc.processed())));
+        LIGHT_TEST(decoder.applied() == 6 + 5);
+        
+        LIGHT_TEST(eur.bids.size() == 4 && eur.bids.best().price == 1.0837);
+        LIGHT_TEST(eur.asks.size() == 2 && eur.asks.best().price == 1.0839);
+        LIGHT_TEST(eur.asks.best().size == 1e5);
+        
+        auto const& jpy = *books.find("USDJPY");
+        LIGHT_TEST(jpy.bids.size() == 2 && jpy.asks.empty());
+        LIGHT_TEST(jpy.bids.best().price == 110.5 && jpy.bids[1].price == 110.4);
+        
+        // Depth limit: worst levels are dropped
+        auto& deep = books["DEEP"];
+        for(int i = 0; i < 10; ++i)
+            deep.bids.set(100 + i, 1);
+        LIGHT_TEST(deep.bids.size() == 4 && deep.bids.best().price == 109 && deep.bids[3].price == 106);
+        
+        // Broken input
+        std::string bad = "35=X\x01" "268=1\x01" "279=0\x01" "269=0\x01" "270=1.2.3\x01";
+        read_cursor brc(bad.data(), bad.size());
+        LIGHT_TEST(!decoder.decode(brc));
+        
+        // Malformed NoMDEntries: negative, non-digit, empty, overflowing
+        for(std::string count : {"-1", "x", "1x", "", "99999999999"}) {
+            std::string msg = "35=X\x01" "268=" + count + "\x01" "279=0\x01" "269=0\x01" "55=BADCOUNT\x01" "270=5\x01" "271=1\x01";
+            read_cursor mrc(msg.data(), msg.size());
+            LIGHT_TEST(!decoder.decode(mrc));
+        }
+        LIGHT_TEST(!books.find("BADCOUNT"));
+        
+        // Truncated group: first entry is already applied => book has to be resynced
+        std::string truncated = "35=X\x01" "268=2\x01" "279=0\x01" "269=0\x01" "55=SHORT\x01" "270=5\x01" "271=1\x01";
+        read_cursor trc(truncated.data(), truncated.size());
+        LIGHT_TEST(!decoder.decode(trc));
+        LIGHT_TEST(books.find("SHORT") && books.find("SHORT")->bids.size() == 1);
+    }
+    
+    {
+        struct sample { long long value; const char* text; };
+        
+        auto roundtrip = [&](fix_value_base& out, fix_value_base& in, std::string const& text) {
+            clrbuf();
+            LIGHT_TEST(out.serialize(wc.reset()));
+            LIGHT_TEST(std::string(buf, wc.processed() - 1) == text);
+            LIGHT_TEST(in.deserialize(rc.reset(wc.processed())));
+            LIGHT_TEST(rc.processed() == wc.processed());
+        };
+        
+        for(auto s : std::vector<sample>{
+            {0,                 "19700101-00:00:00.000"},
+            {1492509600000,     "20170418-10:00:00.000"},
+            {1492509659999,     "20170418-10:00:59.999"},
+            {1492509660001,     "20170418-10:01:00.001"},
+            {951782400000,      "20000229-00:00:00.000"},
+            {-1,                "19691231-23:59:59.999"},
+            {4102444799123,     "20991231-23:59:59.123"}})
+        {
+            UTCTimestamp<> ts(s.value), parsed;
+            roundtrip(ts, parsed, s.text);
+            LIGHT_TEST(parsed.value == s.value);
+        }
+        
+        UTCTimestamp<precision::ns> ns(1492509600123456789LL), ns2;
+        roundtrip(ns, ns2, "20170418-10:00:00.123456789");
+        LIGHT_TEST(ns2.value == ns.value);
+        
+        UTCTimestamp<precision::s> sec(1492509600), sec2;
+        roundtrip(sec, sec2, "20170418-10:00:00");
+        LIGHT_TEST(sec2.value == sec.value);
+        
+        UTCDate date(17274), date2;
+        roundtrip(date, date2, "20170418");
+        LIGHT_TEST(date2.value == date.value);
+        
+        UTCTime<precision::us> time(36000000001LL), time2;
+        roundtrip(time, time2, "10:00:00.000001");
+        LIGHT_TEST(time2.value == time.value);
+        
+        // Precision conversion while parsing
+        auto parse = [](std::string text, fix_value_base& v) {
+            text += char(SOH);
+            read_cursor src(text.data(), text.size());
+            return v.deserialize(src);
+        };
+        UTCTimestamp<precision::us> us;
+        LIGHT_TEST(parse("20170418-10:00:00.5", us) && us.value == 1492509600500000LL);
+        LIGHT_TEST(parse("20170418-10:00:00.123456789", us) && us.value == 1492509600123456LL);
+        LIGHT_TEST(parse("20170418-10:00:00", us) && us.value == 1492509600000000LL);
+        
+        LIGHT_TEST(utc_now() > 1492509600000 && utc_now<precision::us>() > 1492509600000000);
+        
+        for(auto bad : {"2017041810:00:00", "20171318-10:00:00", "20170418-25:00:00",
+                        "20170418-10:00:00.", "20170418-10:0a:00", "20170418-10:00:00.1234567890",
+                        "20230231-10:00:00", "20230229-10:00:00", "20170431-10:00:00", "21000229-10:00:00"})
+            LIGHT_TEST(!parse(bad, us));
+        LIGHT_TEST(parse("20240229-10:00:00", us) && parse("20000229", date2) && !parse("20230229", date2));
+        
+    }
+    
+    {
+        using namespace test_dict;
+        
+        LIGHT_TEST(alloc::hooks_installed());
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP")
+              .set<MsgSeqNum>   (1)
+              .set<SendingTime> (1492509600123);
+        NewOrderSingle nos;
+        nos.set<ClOrdID>("ORD-000000000000000001").set<Account>("ACC").set<Price>(1.25).set<Side>('1');
+        nos.at<NoPartyID>().resize(2);
+        nos.at<NoPartyID>()[0].set<PartyID>("USER-WITH-LONG-IDENTIFIER").set<PartyRole>(12);
+        nos.at<NoPartyID>()[1].set<PartyID>("FIRM").set<PartyRole>(1);
+        Trailer trailer;
+        
+        char out[1_KIB], bin[1_KIB];
+        write_cursor owc(out, sizeof(out));
+        write_cursor bwc(bin, sizeof(bin));
+        LIGHT_TEST(serialize_message(owc, header, nos, trailer));
+        LIGHT_TEST(sbe::serialize_binary_message(bwc, header, nos));
+        
+        msg_template<Header, NewOrderSingle, MsgSeqNum, SendingTime, ClOrdID, Price> tpl;
+        LIGHT_TEST(tpl.build(header, nos));
+        
+        using CachedNOS = cached_msg_t<ClOrdID, Account, NoPartyID, Price, Side>;
+        CachedNOS cached;
+        cached.set<ClOrdID>("ORD-000000000000000001").set<Price>(1.25).set<Side>('1');
+        
+        Header h2;
+        NewOrderSingle n2;
+        Trailer t2;
+        NewOrderSingle group_owner;
+        
+        // Steady state of these operations must not touch the heap
+        std::vector<std::pair<char const*, std::function<void()>>> zero_alloc = {
+            {"serialize_message", [&]() {
+                header.set<MsgSeqNum>(header.at<MsgSeqNum>().value + 1);
+                serialize_message(owc.reset(), header, nos, trailer); }},
+            {"template serialize", [&]() {
+                tpl.serialize(owc.reset(), header, nos); }},
+            {"cached serialize", [&]() {
+                cached.set<Side>(cached.at<Side>().value == '1' ? '2' : '1');
+                serialize_message(owc.reset(), header, cached, trailer); }},
+            {"validate/frame", [&]() {
+                read_cursor src(out, owc.processed());
+                validate_message(src);
+                frame_message(src); }},
+            {"binary serialize", [&]() {
+                sbe::serialize_binary_message(bwc.reset(), header, nos); }},
+            {"binary deserialize", [&]() {
+                read_cursor src(bin, bwc.processed());
+                sbe::deserialize_binary_message(src, h2, n2); }},
+            {"group resize/fill", [&]() {
+                auto& parties = group_owner.at<NoPartyID>().resize(3);
+                for(int i = 0; i < 3; ++i)
+                    parties[i].set<PartyID>("PARTY-WITH-LONG-IDENTIFIER").set<PartyRole>(i);
+            }},
+        };
+        for(auto const& op : zero_alloc) {
+            auto c = alloc::steady_state(op.second);
+            stdprintf("allocations: %% -> %% (%% bytes)", op.first, c.allocations, c.bytes);
+            LIGHT_TEST(c.allocations == 0);
+        }
+        LIGHT_TEST(h2.at<SenderCompID>().value == "MYCOMP" && n2.at<NoPartyID>()[1].at<PartyID>().value == "FIRM");
+        
+        // tag=value parsing goes through sstream deserializer => bounded, growth fails
+        enum : size_t { runs = 10, max_deserialize_allocs = 5 };
+        LIGHT_TEST(serialize_message(owc.reset(), header, nos, trailer));
+        Header h3;
+        NewOrderSingle n3;
+        Trailer t3;
+        bool parsed = true;
+        auto c = alloc::steady_state([&]() {
+            read_cursor src(out, owc.processed());
+            parsed = h3.deserialize(src) && n3.deserialize(src) && t3.deserialize(src) && parsed;
+        }, 3, runs);
+        stdprintf("allocations: deserialize -> %% (%% bytes)", c.allocations, c.bytes);
+        LIGHT_TEST(c.allocations <= max_deserialize_allocs*runs);
+        LIGHT_TEST(parsed && h3.at<MsgSeqNum>().value == header.at<MsgSeqNum>().value);
+        LIGHT_TEST(n3.at<NoPartyID>()[0].at<PartyID>().value == "USER-WITH-LONG-IDENTIFIER");
+    }
+    
+    {
+        using namespace test_dict;
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP")
+              .set<SendingTime> (1492509600000);
+        Trailer trailer;
+        
+        // Two sessions: A (Ethernet/IPv4, with handshake), B (VLAN/IPv6, capture starts mid-message)
+        std::vector<std::string> sent[2];
+        std::string stream[2];
+        for(int s = 0; s < 2; ++s) {
+            for(int i = 0; i < 6; ++i) {
+                NewOrderSingle nos;
+                nos.set<ClOrdID>("PCAP-" + std::to_string(s) + "-" + std::to_string(i)).set<Price>(1.5 + i).set<Side>('1');
+                header.set<MsgSeqNum>(i + 1);
+                char out[1024];
+                write_cursor wc(out, sizeof(out));
+                LIGHT_TEST(serialize_message(wc, header, nos, trailer));
+                sent[s].emplace_back(out, wc.processed());
+                stream[s] += sent[s].back();
+            }
+        }
+        size_t lost_tail = sent[1][0].size() - 40;
+        stream[1] = sent[1][0].substr(40) + stream[1].substr(sent[1][0].size()); // tail of lost message
+        sent[1].erase(sent[1].begin());
+        
+        auto put16 = [](std::string& dst, unsigned v) { dst += char(v >> 8); dst += char(v); };
+        auto put32 = [&](std::string& dst, std::uint32_t v) { put16(dst, v >> 16); put16(dst, v & 0xFFFF); };
+        
+        auto frame = [&](int s, std::uint32_t seq, std::uint8_t flags, std::string const& payload) {
+            std::string tcp;
+            put16(tcp, s ? 40000 : 5001); put16(tcp, 9878);
+            put32(tcp, seq); put32(tcp, 0);
+            tcp += char(0x50); tcp += char(flags);
+            put16(tcp, 65535); put32(tcp, 0);
+            tcp += payload;
+            
+            std::string pkt(12, '\x02');
+            if(s == 0) {
+                put16(pkt, 0x0800);
+                pkt += char(0x45); pkt += char(0);
+                put16(pkt, unsigned(20 + tcp.size())); put32(pkt, 0x4000);
+                pkt += char(64); pkt += char(6); put16(pkt, 0);
+                put32(pkt, 0x0A000001); put32(pkt, 0x0A000002);
+                pkt += tcp + std::string(payload.empty() ? 6 : 0, '\0'); // Ethernet padding
+            } else {
+                put16(pkt, 0x8100); put16(pkt, 42); put16(pkt, 0x86DD);
+                put32(pkt, 0x60000000); put16(pkt, unsigned(tcp.size()));
+                pkt += char(6); pkt += char(64);
+                pkt += std::string(15, '\0') + '\x01' + std::string(15, '\0') + '\x02';
+                pkt += tcp;
+            }
+            return pkt;
+        };
+        
+        // Segments: split, reordered, retransmitted with overlap
+        std::vector<std::string> packets;
+        packets.push_back(frame(0, 999, pcap::tcp_syn, ""));
+        std::uint32_t seq[2] = {1000, 777000};
+        std::vector<std::pair<int, std::pair<size_t, size_t>>> chunks; // session, [from, to)
+        for(int s = 0; s < 2; ++s)
+            for(size_t pos = 0; pos < stream[s].size(); pos += 97)
+                chunks.push_back({s, {pos, std::min(stream[s].size(), pos + 97)}});
+        std::swap(chunks[3], chunks[4]);                    // out of order (A)
+        chunks.insert(chunks.begin() + 6, {0, {50, 150}});  // overlapping retransmission (A)
+        auto first_b = *std::find_if(chunks.begin(), chunks.end(), [](decltype(chunks[0]) c) { return c.first == 1; });
+        chunks.insert(chunks.begin() + 2, first_b);         // B starts, its copy is retransmission
+        for(auto const& c : chunks) {
+            auto const& data = stream[c.first];
+            packets.push_back(frame(c.first, seq[c.first] + std::uint32_t(c.second.first), 0,
+                data.substr(c.second.first, c.second.second - c.second.first)));
+        }
+        packets.push_back(frame(0, seq[0] + std::uint32_t(stream[0].size()), pcap::tcp_fin, ""));
+        
+        auto le32 = [](std::string& dst, std::uint32_t v) { dst.append(reinterpret_cast<char const*>(&v), 4); };
+        auto le16 = [](std::string& dst, std::uint16_t v) { dst.append(reinterpret_cast<char const*>(&v), 2); };
+        std::uint64_t base_ns = 1492509600000000000ULL;
+        
+        std::string classic;
+        le32(classic, 0xA1B2C3D4); le16(classic, 2); le16(classic, 4);
+        le32(classic, 0); le32(classic, 0); le32(classic, 65535); le32(classic, pcap::link_ethernet);
+        for(size_t i = 0; i < packets.size(); ++i) {
+            std::uint64_t ts = base_ns + i*1000;
+            le32(classic, std::uint32_t(ts/1000000000)); le32(classic, std::uint32_t(ts%1000000000/1000));
+            le32(classic, std::uint32_t(packets[i].size())); le32(classic, std::uint32_t(packets[i].size()));
+            classic += packets[i];
+        }
+        
+        std::string ng;
+        le32(ng, 0x0A0D0D0A); le32(ng, 28); le32(ng, 0x1A2B3C4D); le16(ng, 1); le16(ng, 0);
+        le32(ng, 0xFFFFFFFF); le32(ng, 0xFFFFFFFF); le32(ng, 28);
+        le32(ng, 1); le32(ng, 32); le16(ng, pcap::link_ethernet); le16(ng, 0); le32(ng, 65535);
+        le16(ng, 9); le16(ng, 1); le32(ng, 9); le32(ng, 0); le32(ng, 32);   // if_tsresol = ns
+        le32(ng, 5); le32(ng, 16); le32(ng, 0); le32(ng, 16);              // unknown block
+        for(size_t i = 0; i < packets.size(); ++i) {
+            std::uint64_t ts = base_ns + i*1000;
+            std::uint32_t padded = std::uint32_t((packets[i].size() + 3)/4*4);
+            le32(ng, 6); le32(ng, 32 + padded); le32(ng, 0);
+            le32(ng, std::uint32_t(ts >> 32)); le32(ng, std::uint32_t(ts));
+            le32(ng, std::uint32_t(packets[i].size())); le32(ng, std::uint32_t(packets[i].size()));
+            ng += packets[i] + std::string(padded - packets[i].size(), '\0');
+            le32(ng, 32 + padded);
+        }
+        
+        const char* corpus_path = "preFIX_test.corpus";
+        for(std::string const* image : {&classic, &ng}) {
+            pcap::reassembler tcp;
+            std::vector<pcap::record> records;
+            std::vector<std::string> frames;
+            pcap::corpus_writer writer;
+            LIGHT_TEST(writer.open(corpus_path));
+            LIGHT_TEST(pcap::extract(image->data(), image->size(), tcp, [&](pcap::record const& r) {
+                records.push_back(r);
+                frames.emplace_back(r.frame.pointer(), r.frame.left());
+                writer.write(r);
+            }));
+            LIGHT_TEST(writer.close());
+            
+            LIGHT_TEST(tcp.sessions() == 2 && records.size() == 11);
+            LIGHT_TEST(tcp.session(0).to_string() == "10.0.0.1:5001 -> 10.0.0.2:9878");
+            LIGHT_TEST(tcp.session(1).to_string() == "[0:0:0:0:0:0:0:1]:40000 -> [0:0:0:0:0:0:0:2]:9878");
+            LIGHT_TEST(tcp.stats().gaps == 0 && tcp.stats().dropped == lost_tail);
+            
+            size_t next[2] = {0, 0};
+            for(size_t i = 0; i < records.size(); ++i) {
+                auto s = records[i].session;
+                LIGHT_TEST(s < 2 && frames[i] == sent[s][next[s]++]);
+                LIGHT_TEST(dict::validate_message(read_cursor(frames[i].data(), int(frames[i].size()))));
+                LIGHT_TEST(i == 0 || records[i].timestamp_ns >= records[i - 1].timestamp_ns);
+                LIGHT_TEST(records[i].timestamp_ns >= base_ns && (records[i].timestamp_ns - base_ns) % 1000 == 0);
+            }
+            LIGHT_TEST(next[0] == 6 && next[1] == 5);
+            
+            pcap::mapped_file file;
+            pcap::corpus_reader reader;
+            LIGHT_TEST(file.open(corpus_path) && reader.open(file.data(), file.size()));
+            pcap::record r{0, 0, read_cursor(nullptr, 0)};
+            size_t count = 0;
+            while(reader.next(r)) {
+                LIGHT_TEST(r.session == records[count].session && r.timestamp_ns == records[count].timestamp_ns);
+                LIGHT_TEST(std::string(r.frame.pointer(), r.frame.left()) == frames[count]);
+                ++count;
+            }
+            LIGHT_TEST(count == records.size() && !reader.error());
+            
+            // Truncated capture: error is reported, complete packets are still processed
+            pcap::reassembler partial;
+            size_t partial_count = 0;
+            LIGHT_TEST(!pcap::extract(image->data(), image->size() - 10, partial,
+                [&](pcap::record const&) { ++partial_count; }));
+            LIGHT_TEST(partial_count == records.size());
+        }
+        std::remove(corpus_path);
+        
+        pcap::reassembler tcp;
+        LIGHT_TEST(!pcap::extract(stream[0].data(), stream[0].size(), tcp, [](pcap::record const&) {}));
+        stdprintf("pcap: %% packets, pcapng: %% bytes", packets.size(), ng.size());
+    }
+    
+    {
+        using namespace test_dict;
+        using namespace data_test;
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("n")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP")
+              .set<SendingTime> (1492509600000);
+        Trailer trailer;
+        
+        // Payloads contain SOH and "TAG=" sequences
+        std::string raw("<xml a=\"1\">\x01" "10=000\x01" "</xml>");
+        std::string encoded("\x01\x01" "58=x\x01");
+        Carrier msg;
+        msg.set<RawData>(raw).set<Text>("plain").set<EncodedText>(encoded);
+        msg.at<NoBlobs>().resize(2);
+        msg.at<NoBlobs>()[0].set<Blob>(std::string("a\x01" "b", 3)).set<Text>("first");
+        msg.at<NoBlobs>()[1].set<Blob>(std::string(1000, '\x01')).set<Text>("second");
+        LIGHT_TEST(msg.at<RawDataLength>().value == long(raw.size()));
+        LIGHT_TEST(msg.at<EncodedTextLen>().value == long(encoded.size()));
+        LIGHT_TEST(msg.at<NoBlobs>()[1].at<BlobLen>().value == 1000);
+        
+        char out[4096];
+        write_cursor wc(out, sizeof(out));
+        LIGHT_TEST(serialize_message(wc, header, msg, trailer));
+        LIGHT_TEST(dict::validate_message(read_cursor(out, wc.processed())));
+        stdcout(replace_SOH(std::string(out, 120)), "<---- data");
+        
+        Header h2;
+        Carrier m2;
+        Trailer t2;
+        read_cursor src(out, wc.processed());
+        LIGHT_TEST(h2.deserialize(src) && m2.deserialize(src) && t2.deserialize(src));
+        LIGHT_TEST(src.left() == 0 && t2.at<CheckSum>().present());
+        LIGHT_TEST(m2.at<RawData>().value == raw && m2.at<Text>().value == "plain");
+        LIGHT_TEST(m2.at<EncodedText>().value.str() == encoded);
+        LIGHT_TEST(m2.at<EncodedText>().value.data() > out && m2.at<EncodedText>().value.data() < out + wc.processed());
+        LIGHT_TEST(m2.at<NoBlobs>().value.size() == 2);
+        LIGHT_TEST(m2.at<NoBlobs>()[0].at<Blob>().value == std::string("a\x01" "b", 3));
+        LIGHT_TEST(m2.at<NoBlobs>()[1].at<Blob>().value == std::string(1000, '\x01'));
+        LIGHT_TEST(m2.at<NoBlobs>()[1].at<Text>().value == "second");
+        
+        // Copies don't keep binding to source message
+        Carrier copy = m2;
+        LIGHT_TEST(copy.at<RawData>().value == raw);
+        
+        auto body = [](std::string const& fields) {
+            Carrier m;
+            read_cursor rc(fields.data(), int(fields.size()));
+            return m.deserialize(rc) && rc.left() == 0;
+        };
+        LIGHT_TEST( body("95=3\x01" "96=a\x01" "b\x01"));
+        LIGHT_TEST(!body("95=4\x01" "96=a\x01" "b\x01"));           // past the end
+        LIGHT_TEST(!body("95=2\x01" "96=a\x01" "b\x01"));           // no SOH after data
+        LIGHT_TEST(!body("96=abc\x01" "95=3\x01"));                 // data before length
+        LIGHT_TEST(!body("95=-1\x01" "96=\x01"));
+        
+        // Length of previous message isn't reused
+        Carrier reused;
+        std::string first("95=3\x01" "96=abc\x01"), second("96=xyz\x01");
+        read_cursor r1(first.data(), int(first.size())), r2(second.data(), int(second.size()));
+        LIGHT_TEST(reused.deserialize(r1) && !reused.deserialize(r2));
+        
+        // Binary encoding: Data is var-data, DataView references source
+        char bin[4096];
+        write_cursor bwc(bin, sizeof(bin));
+        LIGHT_TEST(sbe::serialize_binary(bwc, msg));
+        Carrier m3;
+        read_cursor brc(bin, bwc.processed());
+        LIGHT_TEST(sbe::deserialize_binary(brc, m3));
+        LIGHT_TEST(m3.at<RawData>().value == raw && m3.at<RawDataLength>().value == long(raw.size()));
+        LIGHT_TEST(m3.at<EncodedText>().value == data_view(encoded));
+        LIGHT_TEST(m3.at<NoBlobs>()[1].at<Blob>().value == std::string(1000, '\x01'));
+        
+        // Bytes >= 0x80 (e.g. encrypted Logon) are summed as unsigned
+        Carrier high;
+        high.set<RawData>(std::string(256, '\xC3'));
+        LIGHT_TEST(serialize_message(wc.reset(), header, high, trailer));
+        int expected = 0;
+        for(int i = 0; i < wc.processed() - 7; ++i)
+            expected += static_cast<unsigned char>(out[i]);
+        LIGHT_TEST(trailer.at<CheckSum>().value == expected % 256);
+        LIGHT_TEST(dict::validate_message(read_cursor(out, wc.processed())));
+        
+        Carrier high2;
+        src = read_cursor(out, wc.processed());
+        LIGHT_TEST(h2.deserialize(src) && high2.deserialize(src) && t2.deserialize(src) && src.left() == 0);
+        LIGHT_TEST(high2.at<RawData>().value == std::string(256, '\xC3'));
+        
+        cached_msg_t<RawDataLength, RawData, Text, EncodedTextLen, EncodedText, NoBlobs> cached;
+        cached.set<RawData>(std::string(256, '\xC3'));
+        write_cursor cwc(bin, sizeof(bin));
+        LIGHT_TEST(serialize_message(cwc, header, cached, trailer));
+        LIGHT_TEST(std::string(bin, cwc.processed()) == std::string(out, wc.processed()));
+        
+        LIGHT_TEST(copy_poss_dup(read_cursor(out, wc.processed()), cwc.reset()));
+        LIGHT_TEST(dict::validate_message(read_cursor(bin, cwc.processed())));
+        
+        msg.clear<RawData>();
+        LIGHT_TEST(!msg.at<RawData>().present() && msg.at<RawDataLength>().value == 0);
+    }
+    
+    {
+        using namespace test_dict;
+        
+        buffer_pool::options opt;
+        opt.cache_size = 4;
+        buffer_pool pool(200, 8, opt);
+        LIGHT_TEST(pool.is_open() && pool.block_size() == 256 && pool.capacity() == 8);
+        
+        // Exhaustion, alignment, handles go back on destruction/move
+        {
+            std::vector<buffer_pool::buffer> all;
+            for(int i = 0; i < 8; ++i)
+                all.push_back(pool.acquire());
+            LIGHT_TEST(!pool.acquire() && pool.available() == 0);
+            for(auto const& b : all)
+                LIGHT_TEST(b && b.capacity() == 256 && reinterpret_cast<uintptr_t>(b.data()) % buffer_pool::cache_line == 0);
+            
+            buffer_pool::buffer moved = std::move(all[0]);
+            LIGHT_TEST(moved && !all[0]);
+            moved = std::move(all[1]);
+            LIGHT_TEST(pool.cached() == 1 && pool.acquire());
+        }
+        LIGHT_TEST(pool.cached() + pool.available() == 8);
+        pool.flush_cache();
+        LIGHT_TEST(pool.cached() == 0 && pool.available() == 8);
+        
+        Header header;
+        header.set<BeginString> ("FIX.4.4")
+              .set<MsgType>     ("D")
+              .set<SenderCompID>("MYCOMP")
+              .set<TargetCompID>("THEIRTCOMP");
+        NewOrderSingle nos;
+        nos.set<Account>("ACC").set<Side>('1');
+        Trailer trailer;
+        
+        // Encoder thread => queue => decoder thread, blocks return from decoder's cache
+        // (cache_size is half of pool => decoder can't strand all blocks)
+        enum : int { count = 2000 };
+        std::mutex lock;
+        std::condition_variable ready;
+        std::deque<buffer_pool::buffer> queue;
+        int exhausted = 0, decoded = 0;
+        std::atomic<int> failed{0};
+        
+        std::thread encoder([&]() {
+            Header h = header;
+            NewOrderSingle n = nos;
+            Trailer t;
+            for(int seq = 1; seq <= count; ++seq) {
+                auto buf = pool.acquire();
+                for(; !buf; buf = pool.acquire()) {
+                    ++exhausted;
+                    std::this_thread::yield();
+                }
+                h.set<MsgSeqNum>(seq);
+                n.set<ClOrdID>("ORD" + std::to_string(seq));
+                auto wc = buf.writer();
+                failed += !serialize_message(wc, h, n, t);
+                buf.resize(wc.processed());
+                
+                std::lock_guard<std::mutex> guard(lock);
+                queue.push_back(std::move(buf));
+                ready.notify_one();
+            }
+        });
+        
+        std::thread decoder([&]() {
+            Header h;
+            NewOrderSingle n;
+            Trailer t;
+            for(int seq = 1; seq <= count; ++seq) {
+                std::unique_lock<std::mutex> guard(lock);
+                ready.wait(guard, [&]() { return !queue.empty(); });
+                auto buf = std::move(queue.front());
+                queue.pop_front();
+                guard.unlock();
+                
+                auto rc = buf.reader();
+                failed += !validate_message(rc);
+                rc = buf.reader();
+                if(h.deserialize(rc) && n.deserialize(rc) && t.deserialize(rc) && rc.left() == 0 &&
+                   h.at<MsgSeqNum>().value == seq && n.at<ClOrdID>().value == "ORD" + std::to_string(seq))
+                    ++decoded;
+            }
+        });
+        
+        encoder.join();
+        decoder.join();
+        stdprintf("buffer_pool: %% messages, encoder waited %% times", decoded, exhausted);
+        LIGHT_TEST(failed == 0 && decoded == count);
+        
+        // Caches of finished threads went back to shared stack
+        pool.flush_cache();
+        LIGHT_TEST(pool.available() == pool.capacity());
+        
+        // Acquire/encode/release doesn't allocate
+        auto c = alloc::steady_state([&]() {
+            auto buf = pool.acquire();
+            auto wc = buf.writer();
+            serialize_message(wc, header, nos, trailer);
+            buf.resize(wc.processed());
+        });
+        LIGHT_TEST(c.allocations == 0);
+        
+        // Without thread cache every block goes through shared stack
+        opt.cache_size = 0;
+        opt.hugepages = true;
+        buffer_pool shared(64, 2, opt);
+        LIGHT_TEST(shared.is_open());
+        {
+            auto a = shared.acquire(), b = shared.acquire();
+            LIGHT_TEST(a && b && !shared.acquire() && shared.cached() == 0);
+        }
+        LIGHT_TEST(shared.available() == 2);
+        
+        // Single-block cache keeps spilling to shared stack
+        opt.cache_size = 1;
+        opt.hugepages = false;
+        buffer_pool tiny(64, 4, opt);
+        for(int i = 0; i < 1000; ++i) {
+            auto a = tiny.acquire(), b = tiny.acquire();
+            LIGHT_TEST(a && b);
+        }
+        LIGHT_TEST(tiny.cached() <= 1 && tiny.cached() + tiny.available() == 4);
+    }
+    
     {
         using namespace preFIX::types::details::example;
         
@@ -0,0 +1,603 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Dictionary generator: QuickFIX-style XML data dictionary => preFIX header.
+ * Usage:
+ *   AX_PREFIX_DICTGEN <dictionary.xml> <output.hpp> <namespace>
+ * Emits field_base/group_base typedefs for every used field, msg_t-based
+ * structs for Header, Trailer and messages (components are expanded inline),
+ * enum constants for CHAR/INT fields and MsgType => message dispatcher.
+ */
+
+namespace {
+    
+    /// ------------------------! Minimal XML !------------------------ ///
+    
+    struct xml_node {
+        std::string name;
+        std::map<std::string, std::string> attrs;
+        std::vector<xml_node> children;
+        
+        std::string attr(std::string const& key, std::string const& def = "") const {
+            auto it = attrs.find(key);
+            return it != attrs.end() ? it->second : def;
+        }
+        
+        xml_node const* child(std::string const& child_name) const {
+            for(auto const& c : children)
+                if(c.name == child_name)
+                    return &c;
+            return nullptr;
+        }
+    };
+    
+    class xml_parser {
+    private:
+        std::string const& text_;
+        size_t pos_;
+        
+        [[noreturn]] void fail(std::string const& what) const {
+            size_t line = 1 + std::count(text_.begin(), text_.begin() + std::min(pos_, text_.size()), '\n');
+            throw std::runtime_error("XML: " + what + " at line " + std::to_string(line));
+        }
+        
+        bool starts(char const* s) const {
+            return text_.compare(pos_, std::char_traits<char>::length(s), s) == 0; }
+        
+        void skip_until(char const* s) {
+            size_t end = text_.find(s, pos_);
+            if(end == std::string::npos)
+                fail(std::string("missing ") + s);
+            pos_ = end + std::char_traits<char>::length(s);
+        }
+        
+        void skip_space() {
+            while(pos_ < text_.size() && std::isspace((unsigned char)text_[pos_]))
+                ++pos_;
+        }
+        
+        /// Skips text, comments, declarations until next element tag
+        void skip_misc() {
+            for(;;) {
+                while(pos_ < text_.size() && text_[pos_] != '<')
+                    ++pos_;
+                if(starts("<!--"))          skip_until("-->");
+                else if(starts("<?"))       skip_until("?>");
+                else if(starts("<![CDATA[")) skip_until("]]>");
+                else if(starts("<!"))       skip_until(">");
+                else return;
+            }
+        }
+        
+        std::string name() {
+            size_t begin = pos_;
+            while(pos_ < text_.size() && (std::isalnum((unsigned char)text_[pos_]) ||
+                  text_[pos_] == '_' || text_[pos_] == '-' || text_[pos_] == ':' || text_[pos_] == '.'))
+                ++pos_;
+            if(begin == pos_)
+                fail("name expected");
+            return text_.substr(begin, pos_ - begin);
+        }
+        
+        static std::string unescape(std::string s) {
+            static const std::pair<char const*, char> entities[] = {
+                {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}};
+            for(auto const& e : entities)
+                for(size_t p; (p = s.find(e.first)) != std::string::npos;)
+                    s.replace(p, std::char_traits<char>::length(e.first), 1, e.second);
+            return s;
+        }
+        
+        xml_node element() {
+            if(!starts("<"))
+                fail("'<' expected");
+            ++pos_;
+            
+            xml_node node;
+            node.name = name();
+            
+            for(;;) {
+                skip_space();
+                if(starts("/>")) {
+                    pos_ += 2;
+                    return node;
+                }
+                if(starts(">")) {
+                    ++pos_;
+                    break;
+                }
+                
+                std::string key = name();
+                skip_space();
+                if(!starts("="))
+                    fail("'=' expected");
+                ++pos_;
+                skip_space();
+                
+                char quote = pos_ < text_.size() ? text_[pos_] : 0;
+                if(quote != '"' && quote != '\'')
+                    fail("quote expected");
+                size_t end = text_.find(quote, ++pos_);
+                if(end == std::string::npos)
+                    fail("unterminated attribute");
+                node.attrs[key] = unescape(text_.substr(pos_, end - pos_));
+                pos_ = end + 1;
+            }
+            
+            for(;;) {
+                skip_misc();
+                if(pos_ >= text_.size())
+                    fail("unexpected end of document");
+                if(starts("</")) {
+                    pos_ += 2;
+                    if(name() != node.name)
+                        fail("mismatched closing tag of " + node.name);
+                    skip_space();
+                    if(!starts(">"))
+                        fail("'>' expected");
+                    ++pos_;
+                    return node;
+                }
+                node.children.push_back(element());
+            }
+        }
+    
+    public:
+        explicit xml_parser(std::string const& text) : text_(text), pos_(0) {}
+        
+        xml_node parse() {
+            skip_misc();
+            return element();
+        }
+    };
+    
+    
+    /// ------------------------! Dictionary model !------------------------ ///
+    
+    struct field_def {
+        int number;
+        std::string name;
+        std::string type;
+        std::vector<std::pair<std::string, std::string>> values;  // enum => description
+        std::string length;     // LENGTH field of DATA field
+        bool used = false;
+    };
+    
+    /// Flattened member of message/group: field or group
+    struct member {
+        std::string field;      // field name (count field for groups)
+        int group;              // index in groups, -1 for plain field
+    };
+    
+    struct group_def {
+        std::string name;       // C++ name
+        std::string field;      // count field
+        std::vector<member> members;
+    };
+    
+    struct message_def {
+        std::string name;
+        std::string msg_type;
+        std::vector<member> members;
+    };
+    
+    class dictionary {
+    public:
+        std::string version;
+        std::map<std::string, field_def> fields;
+        std::vector<group_def> groups;
+        message_def header, trailer;
+        std::vector<message_def> messages;
+    
+    private:
+        std::map<std::string, xml_node const*> components_;
+        
+        static bool same(std::vector<member> const& a, std::vector<member> const& b) {
+            if(a.size() != b.size())
+                return false;
+            for(size_t i = 0; i < a.size(); ++i)
+                if(a[i].field != b[i].field || a[i].group != b[i].group)
+                    return false;
+            return true;
+        }
+        
+        field_def& use(std::string const& name) {
+            auto it = fields.find(name);
+            if(it == fields.end())
+                throw std::runtime_error("unknown field " + name);
+            it->second.used = true;
+            if(!it->second.length.empty())
+                fields.at(it->second.length).used = true;
+            return it->second;
+        }
+        
+        /// DATA field is paired with "<Name>Length"/"<Name>Len" or preceding tag of LENGTH type
+        void pair_lengths() {
+            std::map<int, std::string> by_number;
+            for(auto const& p : fields)
+                by_number[p.second.number] = p.first;
+            
+            for(auto& p : fields) {
+                auto& f = p.second;
+                if(f.type != "DATA")
+                    continue;
+                for(auto const& name : {f.name + "Length", f.name + "Len"})
+                    if(f.length.empty() && fields.count(name) && fields.at(name).type == "LENGTH")
+                        f.length = name;
+                auto prev = by_number.find(f.number - 1);
+                if(f.length.empty() && prev != by_number.end() && fields.at(prev->second).type == "LENGTH")
+                    f.length = prev->second;
+            }
+        }
+        
+        /// Registers group, identical groups are shared, different ones get suffix
+        int add_group(std::string const& field, std::vector<member> members) {
+            int suffix = 1;
+            for(size_t i = 0; i < groups.size(); ++i) {
+                if(groups[i].field != field)
+                    continue;
+                if(same(groups[i].members, members))
+                    return int(i);
+                ++suffix;
+            }
+            
+            group_def g;
+            g.field = field;
+            g.name = suffix == 1 ? field : field + "_" + std::to_string(suffix);
+            g.members = std::move(members);
+            groups.push_back(std::move(g));
+            return int(groups.size()) - 1;
+        }
+        
+        void flatten(xml_node const& node, std::vector<member>& out, std::set<std::string>& stack) {
+            for(auto const& c : node.children) {
+                std::string name = c.attr("name");
+                if(c.name == "field") {
+                    use(name);
+                    out.push_back({name, -1});
+                } else if(c.name == "group") {
+                    if(!fields.count(name))
+                        throw std::runtime_error("unknown field " + name);
+                    std::vector<member> members;
+                    flatten(c, members, stack);
+                    if(members.empty())
+                        throw std::runtime_error("empty group " + name);
+                    out.push_back({name, add_group(name, std::move(members))});
+                } else if(c.name == "component") {
+                    auto it = components_.find(name);
+                    if(it == components_.end())
+                        throw std::runtime_error("unknown component " + name);
+                    if(!stack.insert(name).second)
+                        throw std::runtime_error("recursive component " + name);
+                    flatten(*it->second, out, stack);
+                    stack.erase(name);
+                }
+            }
+        }
+        
+        message_def make(xml_node const& node, std::string name, std::string msg_type) {
+            message_def m;
+            m.name = std::move(name);
+            m.msg_type = std::move(msg_type);
+            std::set<std::string> stack;
+            flatten(node, m.members, stack);
+            return m;
+        }
+    
+    public:
+        explicit dictionary(xml_node const& root) {
+            if(root.name != "fix")
+                throw std::runtime_error("<fix> root expected");
+            
+            version = root.attr("type", "FIX") + "." + root.attr("major") + "." + root.attr("minor");
+            if(!root.attr("servicepack").empty() && root.attr("servicepack") != "0")
+                version += "SP" + root.attr("servicepack");
+            
+            if(auto f = root.child("fields"))
+                for(auto const& c : f->children) {
+                    field_def fd;
+                    fd.number = std::stoi(c.attr("number"));
+                    fd.name = c.attr("name");
+                    fd.type = c.attr("type");
+                    for(auto const& v : c.children)
+                        if(v.name == "value")
+                            fd.values.emplace_back(v.attr("enum"), v.attr("description"));
+                    fields[fd.name] = fd;
+                }
+            
+            pair_lengths();
+            
+            if(auto c = root.child("components"))
+                for(auto const& comp : c->children)
+                    components_[comp.attr("name")] = &comp;
+            
+            if(auto h = root.child("header"))
+                header = make(*h, "Header", "");
+            if(auto t = root.child("trailer"))
+                trailer = make(*t, "Trailer", "");
+            
+            if(auto m = root.child("messages"))
+                for(auto const& msg : m->children)
+                    messages.push_back(make(msg, msg.attr("name"), msg.attr("msgtype")));
+            
+            // Count fields are carried by group_base, separate typedef is needed only if used alone
+            for(auto& g : groups)
+                if(fields.at(g.field).used)
+                    g.name += "Grp";
+        }
+    };
+    
+    
+    /// ------------------------! Code generation !------------------------ ///
+    
+    /// preFIX type for FIX data type
+    std::string value_type(std::string const& fix_type, std::string const& length = "") {
+        if(fix_type == "DATA" && !length.empty())
+            return "Data<" + length + ">";
+        
+        static const std::map<std::string, std::string> types = {
+            {"INT",             "Int"},
+            {"LENGTH",          "Int"},
+            {"SEQNUM",          "Int"},
+            {"NUMINGROUP",      "Int"},
+            {"DAYOFMONTH",      "Int"},
+            {"TAGNUM",          "Int"},
+            {"FLOAT",           "Float"},
+            {"PRICE",           "Float"},
+            {"PRICEOFFSET",     "Float"},
+            {"QTY",             "Float"},
+            {"QUANTITY",        "Float"},
+            {"AMT",             "Float"},
+            {"PERCENTAGE",      "Float"},
+            {"CHAR",            "Char"},
+            {"BOOLEAN",         "Char"},
+            {"UTCTIMESTAMP",    "UTCTimestamp<>"},
+            {"UTCDATEONLY",     "UTCDate"},
+            {"UTCDATE",         "UTCDate"},
+            {"UTCTIMEONLY",     "UTCTime<>"},
+        };
+        auto it = types.find(fix_type);
+        return it != types.end() ? it->second : "String";
+    }
+    
+    /// Valid C++ identifier from enum description
+    std::string identifier(std::string const& s) {
+        std::string res;
+        for(char c : s)
+            res += std::isalnum((unsigned char)c) ? c : '_';
+        if(res.empty() || std::isdigit((unsigned char)res[0]))
+            res = "_" + res;
+        return res;
+    }
+    
+    std::string quoted(std::string const& s) {
+        std::string res = "\"";
+        for(char c : s) {
+            if(c == '"' || c == '\\')
+                res += '\\';
+            res += c;
+        }
+        return res + "\"";
+    }
+    
+    class generator {
+    private:
+        dictionary const& dict_;
+        std::ostream& out_;
+        std::set<std::string> taken_;   // names of fields and groups
+        
+        /// Mandatory fields are shared with preFIX::dict (serialize_message() relies on them)
+        static char const* builtin(int number) {
+            switch(number) {
+            case 8:  return "preFIX::dict::BeginString";
+            case 9:  return "preFIX::dict::Length";
+            case 10: return "preFIX::dict::CheckSum";
+            default: return nullptr;
+            }
+        }
+        
+        std::string member_type(member const& m) const {
+            return m.group < 0 ? m.field : dict_.groups[m.group].name; }
+        
+        void members(std::vector<member> const& list, char const* indent) {
+            for(size_t i = 0; i < list.size(); ++i)
+                out_ << indent << member_type(list[i]) << (i + 1 < list.size() ? ",\n" : "\n");
+        }
+        
+        void fields() {
+            out_ << "    /// ------------------------! Fields !------------------------ ///\n    \n";
+            size_t width = 0;
+            for(auto const& p : dict_.fields)
+                if(p.second.used)
+                    width = std::max(width, p.first.size());
+            
+            // Data<> refers to its length field => DATA fields go last
+            for(bool data : {false, true}) {
+                for(auto const& p : dict_.fields) {
+                    auto const& f = p.second;
+                    if(!f.used || data != !f.length.empty())
+                        continue;
+                    taken_.insert(f.name);
+                    
+                    out_ << "    using " << f.name << std::string(width - f.name.size(), ' ') << " = ";
+                    if(auto b = builtin(f.number)) {
+                        out_ << b << ";\n";
+                        continue;
+                    }
+                    std::string number = std::to_string(f.number) + ",";
+                    out_ << "field_base<" << number << std::string(number.size() < 7 ? 7 - number.size() : 1, ' ')
+                         << value_type(f.type, f.length) << ">;\n";
+                }
+            }
+            out_ << "    \n    \n";
+        }
+        
+        void enums() {
+            out_ << "    /// ------------------------! Enumerations !------------------------ ///\n    \n";
+            for(auto const& p : dict_.fields) {
+                auto const& f = p.second;
+                auto vt = value_type(f.type);
+                if(!f.used || f.values.empty() || (vt != "Char" && vt != "Int"))
+                    continue;
+                
+                bool is_char = (vt == "Char");
+                if(is_char && std::any_of(f.values.begin(), f.values.end(),
+                    [](std::pair<std::string, std::string> const& v) { return v.first.size() != 1; }))
+                    continue;
+                
+                out_ << "    namespace " << f.name << "_values {\n"
+                     << "        enum : " << (is_char ? "char" : "long") << " {\n";
+                std::set<std::string> names;
+                for(size_t i = 0; i < f.values.size(); ++i) {
+                    auto const& v = f.values[i];
+                    std::string name = identifier(v.second.empty() ? v.first : v.second);
+                    while(!names.insert(name).second)
+                        name += "_";
+                    out_ << "            " << name << " = "
+                         << (is_char ? "'" + std::string(v.first == "'" || v.first == "\\" ? "\\" : "") + v.first + "'" : v.first)
+                         << (i + 1 < f.values.size() ? ",\n" : "\n");
+                }
+                out_ << "        };\n    }\n    \n";
+            }
+            out_ << "    \n";
+        }
+        
+        void groups() {
+            out_ << "    /// ------------------------! Groups !------------------------ ///\n    \n";
+            // Nested groups are always registered before enclosing ones
+            for(auto const& g : dict_.groups) {
+                out_ << "    using " << g.name << " = group_base<" << dict_.fields.at(g.field).number << ",\n";
+                members(g.members, "        ");
+                out_ << "    >;\n    \n";
+                taken_.insert(g.name);
+            }
+            out_ << "    \n";
+        }
+        
+        std::string message_name(message_def const& m) const {
+            return taken_.count(m.name) ? m.name + "Msg" : m.name; }
+        
+        void message(message_def const& m, std::string const& name) {
+            if(m.members.empty())
+                return;
+            out_ << "    struct " << name << " : msg_t<\n";
+            members(m.members, "        ");
+            out_ << "    >{";
+            if(!m.msg_type.empty())
+                out_ << "\n        static char const* msg_type() { return " << quoted(m.msg_type) << "; }\n    ";
+            out_ << "};\n    \n";
+        }
+        
+        void messages() {
+            out_ << "    /// ------------------------! Messages !------------------------ ///\n    \n";
+            message(dict_.header, "Header");
+            message(dict_.trailer, "Trailer");
+            for(auto const& m : dict_.messages)
+                message(m, message_name(m));
+            out_ << "    \n";
+        }
+        
+        /// Binary search over sorted MsgType values, then switch
+        void dispatcher() {
+            std::vector<std::pair<std::string, std::string>> types;
+            for(auto const& m : dict_.messages)
+                if(!m.members.empty())
+                    types.emplace_back(m.msg_type, message_name(m));
+            std::sort(types.begin(), types.end());
+            
+            out_ << "    /// ------------------------! MsgType dispatching !------------------------ ///\n    \n"
+                 << "    /**\n"
+                 << "     * Calls f.template on<Message>() for message with given MsgType.\n"
+                 << "     * @returns false if MsgType is unknown\n"
+                 << "     */\n"
+                 << "    template <typename F>\n"
+                 << "    bool dispatch(std::string const& msg_type, F&& f) {\n"
+                 << "        static char const* const types[] = {\n";
+            for(size_t i = 0; i < types.size(); ++i)
+                out_ << "            " << quoted(types[i].first) << (i + 1 < types.size() ? ",\n" : "\n");
+            out_ << "        };\n"
+                 << "        \n"
+                 << "        auto end = std::end(types);\n"
+                 << "        auto it = std::lower_bound(std::begin(types), end, msg_type,\n"
+                 << "            [](char const* a, std::string const& b) { return b.compare(a) > 0; });\n"
+                 << "        if(it == end || msg_type != *it)\n"
+                 << "            return false;\n"
+                 << "        \n"
+                 << "        switch(it - std::begin(types)) {\n";
+            for(size_t i = 0; i < types.size(); ++i)
+                out_ << "        case " << i << ": f.template on<" << types[i].second << ">(); break;\n";
+            out_ << "        }\n"
+                 << "        return true;\n"
+                 << "    }\n";
+        }
+    
+    public:
+        generator(dictionary const& dict, std::ostream& out) : dict_(dict), out_(out) {}
+        
+        void run(std::string const& source, std::string const& ns) {
+            out_ << "#pragma once\n\n"
+                 << "/// Generated by AX_PREFIX_DICTGEN from " << source << " (" << dict_.version << "), do not edit\n\n"
+                 << "#include <algorithm>\n"
+                 << "#include <iterator>\n"
+                 << "#include <string>\n\n"
+                 << "#include <preFIX.hpp>\n"
+                 << "#include <preFIX_dict.hpp>\n\n"
+                 << "namespace " << ns << " {\n"
+                 << "    using namespace preFIX::types;\n"
+                 << "    using namespace preFIX::dict;\n"
+                 << "    \n"
+                 << "    static char const* const begin_string = " << quoted(dict_.version) << ";\n"
+                 << "    \n";
+            fields();
+            enums();
+            groups();
+            messages();
+            dispatcher();
+            out_ << "\n} // " << ns << "\n";
+        }
+    };
+
+} // anonymous
+
+int main(int argc, char** argv) {
+    if(argc != 4) {
+        std::cerr << "usage: " << argv[0] << " <dictionary.xml> <output.hpp> <namespace>\n";
+        return 1;
+    }
+    
+    try {
+        std::ifstream in(argv[1]);
+        if(!in)
+            throw std::runtime_error(std::string("can't open ") + argv[1]);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        std::string text = ss.str();
+        
+        xml_node root = xml_parser(text).parse();
+        dictionary dict(root);
+        
+        std::ostringstream code;
+        std::string source = argv[1];
+        source = source.substr(source.find_last_of("/\\") + 1);
+        generator(dict, code).run(source, argv[3]);
+        
+        std::ofstream out(argv[2]);
+        out << code.str();
+        if(!out)
+            throw std::runtime_error(std::string("can't write ") + argv[2]);
+    } catch(std::exception const& e) {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        return 1;
+    }
+    
+    return 0;
+}
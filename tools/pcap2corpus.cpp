@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <preFIX_pcap.hpp>
+
+/**
+ * Capture => replay corpus converter.
+ * Usage:
+ *   AX_PREFIX_PCAP2CORPUS <capture.pcap|pcapng> <output.corpus|-> [--port N]
+ * Reassembles TCP streams of capture, frames FIX messages and writes them
+ * as (timestamp, session, frame) records, "-" prints records as text
+ * (SOH => '|'). --port keeps only segments from/to given TCP port.
+ * Sessions and reassembly statistics are reported to stderr.
+ */
+
+using namespace preFIX;
+
+int main(int argc, char** argv) {
+    if(argc != 3 && !(argc == 5 && std::string(argv[3]) == "--port")) {
+        std::cerr << "usage: " << argv[0] << " <capture.pcap|pcapng> <output.corpus|-> [--port N]\n";
+        return 1;
+    }
+    int port = argc == 5 ? std::atoi(argv[4]) : -1;
+    bool text = std::string(argv[2]) == "-";
+    
+    pcap::mapped_file file;
+    if(!file.open(argv[1])) {
+        std::cerr << argv[0] << ": can't open " << argv[1] << "\n";
+        return 1;
+    }
+    
+    pcap::corpus_writer writer;
+    if(!text && !writer.open(argv[2])) {
+        std::cerr << argv[0] << ": can't write " << argv[2] << "\n";
+        return 1;
+    }
+    
+    pcap::packet_reader reader;
+    if(!reader.open(file.data(), file.size())) {
+        std::cerr << argv[0] << ": " << argv[1] << " isn't pcap/pcapng\n";
+        return 1;
+    }
+    
+    pcap::reassembler tcp;
+    std::vector<size_t> per_session;
+    bool written = true;
+    auto on_record = [&](pcap::record const& r) {
+        if(per_session.size() <= r.session)
+            per_session.resize(r.session + 1);
+        ++per_session[r.session];
+        
+        if(!text) {
+            written = writer.write(r) && written;
+            return;
+        }
+        std::string frame = replace_SOH(std::string(r.frame.pointer(), r.frame.left()));
+        std::printf("%llu.%09llu %u %s\n",
+            (unsigned long long)(r.timestamp_ns/1000000000), (unsigned long long)(r.timestamp_ns%1000000000),
+            r.session, frame.c_str());
+    };
+    
+    pcap::packet p;
+    pcap::segment s;
+    size_t packets = 0;
+    while(reader.next(p)) {
+        ++packets;
+        if(!pcap::decode_tcp(p, s) || (port >= 0 && s.key.sport != port && s.key.dport != port))
+            continue;
+        tcp.push(p.timestamp_ns, s, on_record);
+    }
+    
+    if(!text && !(writer.close() && written)) {
+        std::cerr << argv[0] << ": can't write " << argv[2] << "\n";
+        return 1;
+    }
+    
+    auto const& st = tcp.stats();
+    std::fprintf(stderr, "packets=%zu tcp=%zu messages=%zu sessions=%zu gaps=%zu dropped_bytes=%zu\n",
+        packets, st.packets, st.messages, tcp.sessions(), st.gaps, st.dropped);
+    for(std::uint32_t i = 0; i < tcp.sessions(); ++i)
+        std::fprintf(stderr, "  session %u: %s, %zu messages\n",
+            i, tcp.session(i).to_string().c_str(), i < per_session.size() ? per_session[i] : size_t(0));
+    
+    if(reader.error()) {
+        std::cerr << argv[0] << ": " << argv[1] << " is truncated or malformed\n";
+        return 2;
+    }
+    return 0;
+}